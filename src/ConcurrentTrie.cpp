@@ -0,0 +1,201 @@
+/**
+ * @file ConcurrentTrie.cpp
+ * @brief Trie that accepts inserts while /predict reads it
+ * @version 1.0
+ */
+
+#include "ConcurrentTrie.h"
+
+#include <algorithm>
+
+#include "Epoch.h"
+
+using namespace std;
+
+// Retired lists kept before a writer tries to free them
+static const size_t RECLAIM_THRESHOLD = 1024;
+
+ConcurrentTrie::ConcurrentTrie() {}
+
+ConcurrentTrie::~ConcurrentTrie() {
+    // No reader may still be running, so everything is freed directly
+    for (auto& entry : retired)
+        delete entry.second;
+
+    vector<const Children*> pending;
+    if (const Children* children = root.children.load(memory_order_relaxed))
+        pending.push_back(children);
+    while (!pending.empty()) {
+        const Children* children = pending.back();
+        pending.pop_back();
+        for (auto& edge : *children) {
+            if (const Children* grandchildren = edge.second->children.load(memory_order_relaxed))
+                pending.push_back(grandchildren);
+            delete edge.second;
+        }
+        delete children;
+    }
+}
+
+const ConcurrentTrie::Node* ConcurrentTrie::findChild(const Node* node, char32_t key) {
+    const Children* children = node->children.load(memory_order_acquire);
+    if (!children)
+        return nullptr;
+
+    auto edge = lower_bound(children->begin(),
+                            children->end(),
+                            key,
+                            [](const pair<char32_t, Node*>& edge, char32_t key) {
+                                return edge.first < key;
+                            });
+    return edge != children->end() && edge->first == key ? edge->second : nullptr;
+}
+
+const ConcurrentTrie::Node* ConcurrentTrie::walk(const u32string& prefix) const {
+    const Node* node = &root;
+    for (char32_t c : prefix) {
+        node = findChild(node, c);
+        if (!node)
+            return nullptr;
+    }
+    return node;
+}
+
+bool ConcurrentTrie::insertLocked(const u32string& word) {
+    // The lock excludes other writers, so this thread's view is current
+    Node* node = &root;
+    for (char32_t c : word) {
+        const Children* children = node->children.load(memory_order_relaxed);
+        Node* next = const_cast<Node*>(findChild(node, c));
+        if (!next) {
+            // Copy-on-write: the new list is complete before it is published
+            next = new Node();
+            Children* grown = new Children();
+            if (children) {
+                grown->reserve(children->size() + 1);
+                *grown = *children;
+            }
+            auto position = lower_bound(grown->begin(),
+                                        grown->end(),
+                                        c,
+                                        [](const pair<char32_t, Node*>& edge, char32_t key) {
+                                            return edge.first < key;
+                                        });
+            grown->insert(position, make_pair(c, next));
+            node->children.store(grown, memory_order_release);
+
+            if (children)
+                retired.emplace_back(Epoch::retire(), children);
+        }
+        node = next;
+    }
+
+    if (node->isEndOfWord.load(memory_order_relaxed))
+        return false;
+    node->isEndOfWord.store(true, memory_order_release);
+    wordCount.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void ConcurrentTrie::reclaim() {
+    uint64_t oldestReader = Epoch::oldestReader();
+    auto kept = remove_if(retired.begin(), retired.end(), [&](auto& entry) {
+        if (!Epoch::isReclaimable(entry.first, oldestReader))
+            return false;
+        delete entry.second;
+        return true;
+    });
+    retired.erase(kept, retired.end());
+}
+
+bool ConcurrentTrie::insert(const u32string& word) {
+    lock_guard<mutex> guard(writeLock);
+    bool inserted = insertLocked(word);
+    if (retired.size() >= RECLAIM_THRESHOLD)
+        reclaim();
+    return inserted;
+}
+
+size_t ConcurrentTrie::insertBatch(const vector<u32string>& words) {
+    lock_guard<mutex> guard(writeLock);
+    size_t inserted = 0;
+    for (const u32string& word : words) {
+        inserted += insertLocked(word);
+        if (retired.size() >= RECLAIM_THRESHOLD)
+            reclaim();
+    }
+    reclaim();
+    return inserted;
+}
+
+bool ConcurrentTrie::search(const u32string& word) const {
+    Epoch::ReadGuard guard;
+    const Node* node = walk(word);
+    return node && node->isEndOfWord.load(memory_order_acquire);
+}
+
+bool ConcurrentTrie::startsWith(const u32string& prefix) const {
+    Epoch::ReadGuard guard;
+    const Node* node = walk(prefix);
+    return node && (node->isEndOfWord.load(memory_order_acquire) ||
+                    node->children.load(memory_order_acquire));
+}
+
+size_t ConcurrentTrie::collectSuggestions(const u32string& prefix,
+                                          size_t maxSuggestions,
+                                          vector<u32string>& suggestions) const {
+    if (maxSuggestions == 0)
+        return 0;
+
+    Epoch::ReadGuard guard;
+    const Node* node = walk(prefix);
+    if (!node)
+        return 0;
+
+    // Depth-first in key order; each frame keeps the list it loaded, so a
+    // concurrent insert never shifts the iteration under it
+    struct Frame {
+        const Children* children;
+        size_t next;
+        size_t depth;  // Word length above this frame's edges
+    };
+    vector<Frame> stack;
+    u32string word = prefix;
+    size_t added = 0;
+
+    if (node->isEndOfWord.load(memory_order_acquire)) {
+        suggestions.push_back(word);
+        added++;
+    }
+    if (const Children* children = node->children.load(memory_order_acquire))
+        stack.push_back({children, 0, prefix.size()});
+
+    while (!stack.empty() && added < maxSuggestions) {
+        Frame& frame = stack.back();
+        if (frame.next == frame.children->size()) {
+            stack.pop_back();
+            continue;
+        }
+
+        const auto& edge = (*frame.children)[frame.next++];
+        word.resize(frame.depth);
+        word.push_back(edge.first);
+
+        if (edge.second->isEndOfWord.load(memory_order_acquire)) {
+            suggestions.push_back(word);
+            added++;
+        }
+        if (const Children* children = edge.second->children.load(memory_order_acquire))
+            stack.push_back({children, 0, word.size()});
+    }
+    return added;
+}
+
+size_t ConcurrentTrie::getWordCount() const {
+    return wordCount.load(memory_order_relaxed);
+}
+
+size_t ConcurrentTrie::getPendingReclaim() const {
+    lock_guard<mutex> guard(writeLock);
+    return retired.size();
+}
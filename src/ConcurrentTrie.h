@@ -0,0 +1,92 @@
+/**
+ * @file ConcurrentTrie.h
+ * @brief Trie that accepts inserts while /predict reads it
+ * @version 1.0
+ *
+ * Each node publishes its sorted child list through one atomic pointer.
+ * Writers never modify a published list: they copy it with the new child,
+ * store the copy with release semantics and retire the old list to the
+ * epoch reclaimer (see Epoch.h). Readers load with acquire semantics and
+ * never lock, so lookups see either the old or the new list, both complete.
+ * Nodes themselves are only freed with the trie.
+ */
+
+#ifndef CONCURRENTTRIE_H
+#define CONCURRENTTRIE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ConcurrentTrie {
+  public:
+    ConcurrentTrie();
+    ~ConcurrentTrie();
+    ConcurrentTrie(const ConcurrentTrie&) = delete;
+    ConcurrentTrie& operator=(const ConcurrentTrie&) = delete;
+
+    /**
+     * @name insert
+     * @brief Adds a word; safe concurrently with readers and other writers
+     * @param word Word (UTF-32, lowercase)
+     * @return True if the word was not in the trie yet
+     */
+    bool insert(const std::u32string& word);
+
+    /**
+     * @name insertBatch
+     * @brief Adds many words under one writer lock
+     * @return Number of new words
+     */
+    size_t insertBatch(const std::vector<std::u32string>& words);
+
+    bool search(const std::u32string& word) const;
+    bool startsWith(const std::u32string& prefix) const;
+
+    /**
+     * @name collectSuggestions
+     * @brief Appends up to maxSuggestions words starting with prefix, in code point order
+     * @param prefix Prefix (UTF-32, lowercase)
+     * @param maxSuggestions Maximum number of words
+     * @param suggestions Output words
+     * @return Number of words appended
+     */
+    size_t collectSuggestions(const std::u32string& prefix,
+                              size_t maxSuggestions,
+                              std::vector<std::u32string>& suggestions) const;
+
+    size_t getWordCount() const;
+
+    /**
+     * @name getPendingReclaim
+     * @brief Retired child lists still waiting for readers to finish
+     */
+    size_t getPendingReclaim() const;
+
+  private:
+    struct Node;
+    typedef std::vector<std::pair<char32_t, Node*>> Children;
+
+    struct Node {
+        std::atomic<const Children*> children{nullptr};
+        std::atomic<bool> isEndOfWord{false};
+    };
+
+    static const Node* findChild(const Node* node, char32_t key);
+    const Node* walk(const std::u32string& prefix) const;
+    bool insertLocked(const std::u32string& word);
+    void reclaim();
+
+    Node root;
+    std::atomic<size_t> wordCount{0};
+
+    // Serializes writers; readers never take it
+    mutable std::mutex writeLock;
+    // Unlinked child lists and the epoch they were retired at
+    std::vector<std::pair<uint64_t, const Children*>> retired;
+};
+
+#endif
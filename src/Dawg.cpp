@@ -0,0 +1,295 @@
+/**
+ * @file Dawg.cpp
+ * @brief Minimal acyclic automaton (DAWG) over the vocabulary
+ * @version 1.0
+ */
+
+#include "Dawg.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+// File layout: magic, state count, edge count, word count, then
+// firstEdge[states + 1], stateWords[states], labels[edges], targets[edges]
+static const char DAWG_MAGIC[8] = {'E', 'D', 'A', 'D', 'A', 'W', 'G', '1'};
+static const uint32_t FINAL_FLAG = 0x80000000U;
+static const uint32_t NO_STATE = 0xFFFFFFFFU;
+
+//=============================== BUILDER ================================//
+
+DawgBuilder::DawgBuilder() : wordCount(0), registeredStates(0) {
+    // State 0 is the root
+    states.emplace_back();
+}
+
+string DawgBuilder::signature(uint32_t state) const {
+    // Two states are equivalent when finality and every edge match
+    const BuildState& node = states[state];
+    string key(1, node.isFinal ? '\1' : '\0');
+    for (auto& edge : node.edges) {
+        key.push_back((char)edge.first);
+        key.append((const char*)&edge.second, sizeof(edge.second));
+    }
+    return key;
+}
+
+uint32_t DawgBuilder::newState() {
+    if (freeStates.empty()) {
+        states.emplace_back();
+        return (uint32_t)states.size() - 1;
+    }
+
+    uint32_t state = freeStates.back();
+    freeStates.pop_back();
+    states[state] = BuildState();
+    return state;
+}
+
+void DawgBuilder::minimize(size_t downTo) {
+    // Children are registered (or merged) before their parents, so their
+    // word counts are already known
+    while (uncheckedPath.size() > downTo) {
+        uint32_t state = uncheckedPath.back();
+        uncheckedPath.pop_back();
+        uint32_t parent = uncheckedPath.empty() ? 0 : uncheckedPath.back();
+
+        BuildState& node = states[state];
+        node.words = node.isFinal ? 1 : 0;
+        for (auto& edge : node.edges)
+            node.words += states[edge.second].words;
+
+        auto registered = registry.emplace(signature(state), state);
+        if (registered.second) {
+            registeredStates++;
+        } else {
+            // An equivalent state exists: the parent's last edge points there
+            states[parent].edges.back().second = registered.first->second;
+            states[state].edges = {};
+            freeStates.push_back(state);
+        }
+    }
+}
+
+bool DawgBuilder::add(const string& word) {
+    if (wordCount && word <= previousWord)
+        return false;
+
+    // Length of the prefix shared with the previous word
+    size_t common = 0;
+    while (common < word.size() && common < previousWord.size() &&
+           word[common] == previousWord[common])
+        common++;
+
+    minimize(common);
+
+    // Appends the new suffix
+    uint32_t state = uncheckedPath.empty() ? 0 : uncheckedPath.back();
+    for (size_t i = common; i < word.size(); i++) {
+        uint32_t next = newState();
+        states[state].edges.emplace_back((uint8_t)word[i], next);
+        uncheckedPath.push_back(next);
+        state = next;
+    }
+    states[state].isFinal = true;
+
+    previousWord = word;
+    wordCount++;
+    return true;
+}
+
+size_t DawgBuilder::getStateCount() const {
+    return registeredStates + 1;
+}
+
+bool DawgBuilder::save(const string& path) {
+    minimize(0);
+
+    // Renumbers reachable states in depth-first order; merged states are dropped
+    vector<uint32_t> newId(states.size(), NO_STATE);
+    vector<uint32_t> order;
+    vector<uint32_t> stack = {0};
+    newId[0] = 0;
+    order.push_back(0);
+    while (!stack.empty()) {
+        uint32_t state = stack.back();
+        stack.pop_back();
+        for (auto& edge : states[state].edges) {
+            if (newId[edge.second] == NO_STATE) {
+                newId[edge.second] = (uint32_t)order.size();
+                order.push_back(edge.second);
+                stack.push_back(edge.second);
+            }
+        }
+    }
+
+    uint32_t stateCount = (uint32_t)order.size();
+    vector<uint32_t> firstEdge(stateCount + 1);
+    vector<uint32_t> stateWords(stateCount, 0);
+    vector<uint8_t> labels;
+    vector<uint32_t> targets;
+
+    for (uint32_t i = 0; i < stateCount; i++) {
+        firstEdge[i] = (uint32_t)labels.size();
+        for (auto& edge : states[order[i]].edges) {
+            labels.push_back(edge.first);
+            targets.push_back(newId[edge.second]);
+        }
+    }
+    firstEdge[stateCount] = (uint32_t)labels.size();
+
+    // Word counts were computed while registering; only the root is left
+    for (uint32_t i = 0; i < stateCount; i++) {
+        const BuildState& node = states[order[i]];
+        uint32_t words = node.words;
+        if (i == 0) {
+            words = node.isFinal ? 1 : 0;
+            for (auto& edge : node.edges)
+                words += states[edge.second].words;
+        }
+        stateWords[i] = words | (node.isFinal ? FINAL_FLAG : 0);
+    }
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (file.fail())
+        return false;
+
+    uint32_t edgeCount = (uint32_t)labels.size();
+    file.write(DAWG_MAGIC, sizeof(DAWG_MAGIC));
+    file.write((const char*)&stateCount, sizeof(stateCount));
+    file.write((const char*)&edgeCount, sizeof(edgeCount));
+    file.write((const char*)&wordCount, sizeof(wordCount));
+    file.write((const char*)firstEdge.data(), firstEdge.size() * sizeof(uint32_t));
+    file.write((const char*)stateWords.data(), stateWords.size() * sizeof(uint32_t));
+    file.write((const char*)labels.data(), labels.size());
+    file.write((const char*)targets.data(), targets.size() * sizeof(uint32_t));
+
+    return !file.fail();
+}
+
+//=============================== READER ================================//
+
+bool Dawg::load(const string& path) {
+    ifstream file(path, ios::binary);
+    if (file.fail())
+        return false;
+
+    char magic[sizeof(DAWG_MAGIC)];
+    uint32_t stateCount, edgeCount, wordCount;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&stateCount, sizeof(stateCount));
+    file.read((char*)&edgeCount, sizeof(edgeCount));
+    file.read((char*)&wordCount, sizeof(wordCount));
+    if (file.fail() || memcmp(magic, DAWG_MAGIC, sizeof(magic)) != 0 || stateCount == 0)
+        return false;
+
+    firstEdge.resize(stateCount + 1);
+    stateWords.resize(stateCount);
+    labels.resize(edgeCount);
+    targets.resize(edgeCount);
+    file.read((char*)firstEdge.data(), firstEdge.size() * sizeof(uint32_t));
+    file.read((char*)stateWords.data(), stateWords.size() * sizeof(uint32_t));
+    file.read((char*)labels.data(), labels.size());
+    file.read((char*)targets.data(), targets.size() * sizeof(uint32_t));
+    if (file.fail() || firstEdge[stateCount] != edgeCount)
+        return false;
+
+    // Rejects corrupt files instead of walking out of bounds
+    for (uint32_t target : targets) {
+        if (target >= stateCount)
+            return false;
+    }
+    return true;
+}
+
+uint32_t Dawg::child(uint32_t state, uint8_t label) const {
+    auto begin = labels.begin() + firstEdge[state];
+    auto end = labels.begin() + firstEdge[state + 1];
+    auto edge = lower_bound(begin, end, label);
+    if (edge == end || *edge != label)
+        return NO_STATE;
+    return targets[edge - labels.begin()];
+}
+
+uint32_t Dawg::walk(const string& prefix) const {
+    if (firstEdge.empty())
+        return NO_STATE;
+
+    uint32_t state = 0;
+    for (char c : prefix) {
+        state = child(state, (uint8_t)c);
+        if (state == NO_STATE)
+            break;
+    }
+    return state;
+}
+
+bool Dawg::contains(const string& word) const {
+    uint32_t state = walk(word);
+    return state != NO_STATE && (stateWords[state] & FINAL_FLAG);
+}
+
+bool Dawg::startsWith(const string& prefix) const {
+    return walk(prefix) != NO_STATE;
+}
+
+uint32_t Dawg::countWithPrefix(const string& prefix) const {
+    uint32_t state = walk(prefix);
+    return state == NO_STATE ? 0 : stateWords[state] & ~FINAL_FLAG;
+}
+
+size_t Dawg::collectSuggestions(const string& prefix,
+                                size_t maxSuggestions,
+                                vector<string>& suggestions) const {
+    uint32_t state = walk(prefix);
+    if (state == NO_STATE || maxSuggestions == 0)
+        return 0;
+
+    // Depth-first, in label order; each frame holds the next edge to follow
+    size_t collected = 0;
+    string word = prefix;
+    vector<pair<uint32_t, uint32_t>> stack;
+
+    if (stateWords[state] & FINAL_FLAG) {
+        suggestions.push_back(word);
+        collected++;
+    }
+    stack.emplace_back(state, firstEdge[state]);
+
+    while (!stack.empty() && collected < maxSuggestions) {
+        auto& frame = stack.back();
+        if (frame.second == firstEdge[frame.first + 1]) {
+            stack.pop_back();
+            if (!stack.empty())
+                word.pop_back();
+            continue;
+        }
+
+        uint32_t edge = frame.second++;
+        uint32_t next = targets[edge];
+        word.push_back((char)labels[edge]);
+
+        if (stateWords[next] & FINAL_FLAG) {
+            suggestions.push_back(word);
+            collected++;
+        }
+        stack.emplace_back(next, firstEdge[next]);
+    }
+
+    return collected;
+}
+
+uint32_t Dawg::getWordCount() const {
+    return firstEdge.empty() ? 0 : stateWords[0] & ~FINAL_FLAG;
+}
+
+size_t Dawg::getStateCount() const {
+    return stateWords.size();
+}
+
+size_t Dawg::getMemoryUsage() const {
+    return firstEdge.size() * sizeof(uint32_t) + stateWords.size() * sizeof(uint32_t) +
+           labels.size() + targets.size() * sizeof(uint32_t);
+}
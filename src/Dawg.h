@@ -0,0 +1,134 @@
+/**
+ * @file Dawg.h
+ * @brief Minimal acyclic automaton (DAWG) over the vocabulary
+ * @version 1.0
+ *
+ * Unlike a trie, a DAWG also shares suffixes ("-ción", "-mente"), so the
+ * vocabulary fits in a few bytes per word. Edges are labeled with UTF-8
+ * bytes; since UTF-8 byte order matches code point order, enumeration is
+ * lexicographic.
+ */
+
+#ifndef DAWG_H
+#define DAWG_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class DawgBuilder
+ * @brief Builds a minimal DAWG from sorted words (Daciuk's incremental algorithm)
+ *
+ * Each word only needs the previous one: the part of the last path that is
+ * no longer shared is minimized (merged into an equivalent registered
+ * state) before the new suffix is appended.
+ */
+class DawgBuilder {
+  public:
+    DawgBuilder();
+
+    /**
+     * @name add
+     * @brief Adds a word; words must come in ascending byte order
+     * @param word UTF-8 word
+     * @return False if the word is out of order (it is ignored)
+     */
+    bool add(const std::string& word);
+
+    /**
+     * @name save
+     * @brief Minimizes the last word and writes the automaton
+     * @param path Output file
+     * @return True if the file was written
+     */
+    bool save(const std::string& path);
+
+    size_t getStateCount() const;
+
+  private:
+    struct BuildState {
+        std::vector<std::pair<uint8_t, uint32_t>> edges;
+        bool isFinal = false;
+        // Words accepted from this state, known once it is registered
+        uint32_t words = 0;
+    };
+
+    void minimize(size_t downTo);
+    uint32_t newState();
+    std::string signature(uint32_t state) const;
+
+    std::vector<BuildState> states;
+    // Merged states, reused so memory tracks the minimal automaton
+    std::vector<uint32_t> freeStates;
+    std::unordered_map<std::string, uint32_t> registry;
+    // Path of the previous word that may still change: states[uncheckedPath[i]]
+    // is the target of byte i
+    std::vector<uint32_t> uncheckedPath;
+    std::string previousWord;
+    uint32_t wordCount;
+    uint32_t registeredStates;
+};
+
+/**
+ * @class Dawg
+ * @brief Read-only DAWG loaded from the file written by DawgBuilder
+ */
+class Dawg {
+  public:
+    /**
+     * @name load
+     * @brief Reads an automaton file
+     * @param path File written by DawgBuilder::save
+     * @return True if the file is a valid automaton
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @name contains
+     * @brief Checks whether a whole word is in the vocabulary
+     */
+    bool contains(const std::string& word) const;
+
+    /**
+     * @name startsWith
+     * @brief Checks if any word starts with the given prefix
+     */
+    bool startsWith(const std::string& prefix) const;
+
+    /**
+     * @name countWithPrefix
+     * @brief Number of words that start with the given prefix
+     */
+    uint32_t countWithPrefix(const std::string& prefix) const;
+
+    /**
+     * @name collectSuggestions
+     * @brief Appends up to maxSuggestions words starting with prefix, in order
+     * @param prefix UTF-8 prefix
+     * @param maxSuggestions Maximum number of words
+     * @param suggestions Output words
+     * @return Number of words appended
+     */
+    size_t collectSuggestions(const std::string& prefix,
+                              size_t maxSuggestions,
+                              std::vector<std::string>& suggestions) const;
+
+    uint32_t getWordCount() const;
+    size_t getStateCount() const;
+    size_t getMemoryUsage() const;
+
+  private:
+    uint32_t walk(const std::string& prefix) const;
+    uint32_t child(uint32_t state, uint8_t label) const;
+
+    // Edges of state s are firstEdge[s] .. firstEdge[s + 1], sorted by label
+    std::vector<uint32_t> firstEdge;
+    // Words accepted from each state (high bit: state is final)
+    std::vector<uint32_t> stateWords;
+    std::vector<uint8_t> labels;
+    std::vector<uint32_t> targets;
+};
+
+#endif
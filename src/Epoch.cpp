@@ -0,0 +1,87 @@
+/**
+ * @file Epoch.cpp
+ * @brief Epoch-based reclamation for lock-free readers
+ * @version 1.0
+ */
+
+#include "Epoch.h"
+
+#include <atomic>
+
+using namespace std;
+
+// One per reader thread, in a list that only grows; slots of exited
+// threads are reused, so the list is as long as the peak thread count
+struct ReaderSlot {
+    atomic<uint64_t> epoch{0};  // 0 while outside any read section
+    atomic<bool> inUse{true};
+    ReaderSlot* next = nullptr;
+};
+
+static atomic<ReaderSlot*> readerSlots{nullptr};
+// Starts at 1 so that 0 can mean "not reading"
+static atomic<uint64_t> globalEpoch{1};
+
+static ReaderSlot* acquireSlot() {
+    for (ReaderSlot* slot = readerSlots.load(memory_order_acquire); slot; slot = slot->next) {
+        bool expected = false;
+        if (!slot->inUse.load(memory_order_relaxed) &&
+            slot->inUse.compare_exchange_strong(expected, true, memory_order_acquire))
+            return slot;
+    }
+
+    ReaderSlot* slot = new ReaderSlot();
+    slot->next = readerSlots.load(memory_order_relaxed);
+    while (!readerSlots.compare_exchange_weak(
+        slot->next, slot, memory_order_release, memory_order_relaxed)) {
+    }
+    return slot;
+}
+
+struct ThreadReader {
+    ReaderSlot* slot = nullptr;
+    unsigned depth = 0;
+
+    ~ThreadReader() {
+        // Slots are never freed, so this is safe even at process exit
+        if (slot)
+            slot->inUse.store(false, memory_order_release);
+    }
+};
+
+static thread_local ThreadReader threadReader;
+
+Epoch::ReadGuard::ReadGuard() {
+    if (threadReader.depth++)
+        return;
+    if (!threadReader.slot)
+        threadReader.slot = acquireSlot();
+
+    threadReader.slot->epoch.store(globalEpoch.load(memory_order_acquire),
+                                   memory_order_relaxed);
+    // Pairs with the fence in oldestReader(): either the writer sees this
+    // announcement, or every load below sees the writer's unlink
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+Epoch::ReadGuard::~ReadGuard() {
+    if (--threadReader.depth == 0)
+        threadReader.slot->epoch.store(0, memory_order_release);
+}
+
+uint64_t Epoch::retire() {
+    // Readers announcing the new epoch started after the unlink
+    return globalEpoch.fetch_add(1, memory_order_seq_cst);
+}
+
+uint64_t Epoch::oldestReader() {
+    atomic_thread_fence(memory_order_seq_cst);
+
+    uint64_t oldest = UINT64_MAX;
+    for (ReaderSlot* slot = readerSlots.load(memory_order_acquire); slot; slot = slot->next) {
+        uint64_t epoch = slot->epoch.load(memory_order_acquire);
+        if (epoch && epoch < oldest)
+            oldest = epoch;
+    }
+    return oldest;
+}
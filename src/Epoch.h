@@ -0,0 +1,58 @@
+/**
+ * @file Epoch.h
+ * @brief Epoch-based reclamation for lock-free readers
+ * @version 1.0
+ *
+ * Readers announce the global epoch while they hold pointers into a shared
+ * structure. A writer that unlinks a block tags it with Epoch::retire() and
+ * frees it once every announced epoch is newer, i.e. once no reader that
+ * could have seen the block is still running. Readers never block or write
+ * shared state other than their own slot.
+ */
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <cstdint>
+
+class Epoch {
+  public:
+    /**
+     * @class ReadGuard
+     * @brief Marks the calling thread as a reader for its lifetime
+     *
+     * Guards nest; only the outermost one announces and clears the epoch.
+     */
+    class ReadGuard {
+      public:
+        ReadGuard();
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    /**
+     * @name retire
+     * @brief Advances the global epoch, call after unlinking a block
+     * @return Epoch to tag the unlinked block with
+     */
+    static uint64_t retire();
+
+    /**
+     * @name isReclaimable
+     * @brief Checks whether blocks retired at an epoch can no longer be read
+     * @param retiredEpoch Value returned by retire()
+     * @param oldestReader Value returned by oldestReader()
+     */
+    static bool isReclaimable(uint64_t retiredEpoch, uint64_t oldestReader) {
+        return retiredEpoch < oldestReader;
+    }
+
+    /**
+     * @name oldestReader
+     * @brief Oldest epoch announced by a running reader, UINT64_MAX if none
+     */
+    static uint64_t oldestReader();
+};
+
+#endif
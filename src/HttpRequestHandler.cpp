@@ -12,27 +12,186 @@
 #include <unicode/uchar.h>
 #include <unicode/ustring.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+// Kernel headers older than 5.6 lack openat2
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#endif
+#endif
+
+#include <algorithm>
 #include <chrono>
 #include <codecvt>
 #include <filesystem>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
 #include <locale>
-#include <regex>
-#include <sstream>
+#include <thread>
 
 #include "HttpResponses.h"
+#include "ImageInfo.h"
+#include "SearchIndex.h"
+#include "TextProcessing.h"
+#include "Trace.h"
 
 using namespace std;
 
-HttpRequestHandler::HttpRequestHandler(string homePath, bool imageMode) {
+// Phrase completions returned by /predict, ahead of single words
+static const size_t PHRASE_SUGGESTIONS = 4;
+// Results listed per search
+static const size_t SEARCH_RESULTS = 100;
+// Default time a search may spend ranking matches
+static const chrono::milliseconds SEARCH_TIMEOUT(1000);
+// Further time an interrupted search gets to list matches unranked
+static const chrono::milliseconds PARTIAL_SEARCH_TIMEOUT(100);
+// Time counting the hits gets, whatever the search itself left
+static const chrono::milliseconds HIT_COUNT_TIMEOUT(100);
+// Least time between two checks of the client connection
+static const chrono::milliseconds CLIENT_CHECK_INTERVAL(10);
+// SQLite virtual machine instructions between two progress callbacks
+static const int PROGRESS_INSTRUCTIONS = 1000;
+
+/**
+ * @brief Memory and cache counters of one connection (sqlite3_db_status), as JSON
+ */
+static string databaseStatusJson(sqlite3* connection) {
+    if (!connection)
+        return "null";
+
+    static const struct {
+        const char* name;
+        int op;
+    } counters[] = {{"cacheUsed", SQLITE_DBSTATUS_CACHE_USED},
+                    {"schemaUsed", SQLITE_DBSTATUS_SCHEMA_USED},
+                    {"stmtUsed", SQLITE_DBSTATUS_STMT_USED},
+                    {"lookasideUsed", SQLITE_DBSTATUS_LOOKASIDE_USED},
+                    {"cacheHit", SQLITE_DBSTATUS_CACHE_HIT},
+                    {"cacheMiss", SQLITE_DBSTATUS_CACHE_MISS}};
+
+    string json = "{";
+    for (const auto& counter : counters) {
+        int current = 0, highwater = 0;
+        sqlite3_db_status(connection, counter.op, &current, &highwater, 0);
+        if (json.size() > 1)
+            json += ", ";
+        json += string("\"") + counter.name + "\": " + to_string(current);
+    }
+    return json + "}";
+}
+
+//=============== SEARCH BUDGET ===============//
+
+/**
+ * @brief Deadline and client of the search running on the current thread
+ *
+ * While one exists, statements on the index connection are interrupted
+ * once the deadline passes or the client hangs up. sqlite3_interrupt()
+ * would also stop the other threads' statements on the shared connection,
+ * so the progress handler interrupts only its own thread's.
+ */
+struct SearchBudget {
+    SearchBudget(chrono::milliseconds timeout, const ClientProbe& isClientGone);
+    ~SearchBudget();
+
+    // Starts a new deadline after an interruption
+    void extend(chrono::milliseconds timeout);
+
+    chrono::steady_clock::time_point deadline;
+    chrono::steady_clock::time_point nextClientCheck;
+    const ClientProbe& isClientGone;
+    bool timedOut;
+    bool clientGone;
+};
+
+// The progress handler runs on the thread stepping the statement
+static thread_local SearchBudget* currentSearchBudget = nullptr;
+
+SearchBudget::SearchBudget(chrono::milliseconds timeout, const ClientProbe& isClientGone)
+    : nextClientCheck(chrono::steady_clock::now()),
+      isClientGone(isClientGone),
+      timedOut(false),
+      clientGone(false) {
+    extend(timeout);
+    currentSearchBudget = this;
+}
+
+SearchBudget::~SearchBudget() {
+    currentSearchBudget = nullptr;
+}
+
+void SearchBudget::extend(chrono::milliseconds timeout) {
+    deadline = timeout.count() ? chrono::steady_clock::now() + timeout
+                               : chrono::steady_clock::time_point::max();
+    timedOut = false;
+}
+
+/**
+ * @brief sqlite3_progress_handler callback of the index connection
+ * @return Nonzero to interrupt the running statement
+ */
+static int searchProgressHandler(void*) {
+    SearchBudget* budget = currentSearchBudget;
+    if (!budget)
+        return 0;
+
+    auto now = chrono::steady_clock::now();
+    if (now >= budget->deadline)
+        budget->timedOut = true;
+    if (budget->isClientGone && now >= budget->nextClientCheck) {
+        budget->nextClientCheck = now + CLIENT_CHECK_INTERVAL;
+        if (budget->isClientGone())
+            budget->clientGone = true;
+    }
+
+    return budget->timedOut || budget->clientGone;
+}
+
+HttpRequestHandler::HttpRequestHandler(string homePath,
+                                       bool imageMode,
+                                       AutocompleteMode autocompleteMode,
+                                       bool infixSuggestions) {
     this->homePath = homePath;
     this->imagemode = imageMode;
+    this->autocompleteMode = autocompleteMode;
+    this->infixSuggestions = infixSuggestions;
+    this->trie = nullptr;
+    this->vocabRowid = 0;
+    this->stopping = false;
+    this->homeRootFd = -1;
+    this->adminEnabled = false;
+    this->autocorrect = false;
+    this->searchTimeout = SEARCH_TIMEOUT;
+    this->coalescedSearches = 0;
+    this->queryLog = nullptr;
+    auto phaseStart = chrono::steady_clock::now();
+
+    // Canonicalizes www root once, so requests never touch it again
+    error_code error;
+    homeRootPath = filesystem::weakly_canonical(filesystem::absolute(homePath), error);
+    if (error) {
+        cerr << "Error resolving home path (" << homePath << "): " << error.message() << endl;
+        homeRootPath = filesystem::absolute(homePath);
+    }
+    cout << "Home absolute: " << homeRootPath << endl;
+
+#ifdef __linux__
+    // Pre-opens root directory, files are resolved beneath it
+    homeRootFd = open(homeRootPath.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (homeRootFd < 0)
+        cerr << "Error opening home directory: " << homeRootPath << endl;
+#endif
 
     // Sets up database location and table name
-    const char* dbFile = imageMode ? "images.db" : "index.db";
-    this->tableName = imageMode ? "images_index" : "webpage_index";
+    IndexNames names = getIndexNames(imageMode);
+    const char* dbFile = names.indexFile;
+    this->tableName = names.indexTable;
 
     // Opens database
     if (sqlite3_open(dbFile, &database) != SQLITE_OK) {
@@ -44,12 +203,11 @@ HttpRequestHandler::HttpRequestHandler(string homePath, bool imageMode) {
     }
 
     // Additional settings
-    if (sqlite3_exec(database, "PRAGMA journal_mode = OFF;", nullptr, nullptr, nullptr) !=
-        SQLITE_OK)
-        cout << "Error: " << sqlite3_errmsg(database) << endl;
+    // Journal and locking modes are left to the writer: mkindex -watch may
+    // upsert into the same WAL database while the server is reading it
     if (sqlite3_exec(database, "PRAGMA synchronous = OFF;", nullptr, nullptr, nullptr) != SQLITE_OK)
         cout << "Error: " << sqlite3_errmsg(database) << endl;
-    if (sqlite3_exec(database, "PRAGMA locking_mode = EXCLUSIVE;", nullptr, nullptr, nullptr) !=
+    if (sqlite3_exec(database, "PRAGMA locking_mode = NORMAL;", nullptr, nullptr, nullptr) !=
         SQLITE_OK)
         cout << "Error: " << sqlite3_errmsg(database) << endl;
     if (sqlite3_exec(database, "PRAGMA mmap_size = 5000000000;", nullptr, nullptr, nullptr) !=
@@ -70,24 +228,66 @@ HttpRequestHandler::HttpRequestHandler(string homePath, bool imageMode) {
 
     cout << "Succesfuly loaded custom settings" << endl;
 
-    // Loads vocabulary into Trie
-    cout << "Loading vocabulary into Trie..." << endl;
-    trie = new Trie();
+    // Enforces the time budget of searches (see SearchBudget)
+    if (database)
+        sqlite3_progress_handler(database, PROGRESS_INSTRUCTIONS, searchProgressHandler, nullptr);
+
+    // Document counts of each term, to order search terms rarest first
+    queryCompiler.open(database, tableName);
+    phaseStart = recordLoadTime("database", phaseStart);
+
+    // Loads the next-word and phrase tables written by mkindex (optional)
+    loadBigrams(names);
+    phaseStart = recordLoadTime("bigrams", phaseStart);
+    loadPhrases(names);
+    phaseStart = recordLoadTime("phrases", phaseStart);
+
+    // Spelling corrections written by mkindex (optional), mapped rather than read
+    if (spelling.load(names.spellingFile))
+        cout << "Loaded " << spelling.getWordCount() << " spelling terms" << endl;
+    phaseStart = recordLoadTime("spelling", phaseStart);
+
+    // Loads the vocabulary automaton, falling back to the Trie if it is missing
+    if (autocompleteMode == AUTOCOMPLETE_DAWG) {
+        bool loaded = dawg.load(names.dawgFile);
+        recordLoadTime("dawg", phaseStart);
+        if (loaded) {
+            cout << "Vocabulary automaton loaded: " << dawg.getWordCount() << " words, "
+                 << dawg.getStateCount() << " states, " << dawg.getMemoryUsage() / 1024
+                 << " KB" << endl;
+            // The suffix array still needs the vocabulary
+            if (!infixSuggestions)
+                return;
+        } else {
+            cerr << "Error loading " << names.dawgFile << ", falling back to Trie" << endl;
+            this->autocompleteMode = AUTOCOMPLETE_TRIE;
+        }
+    }
+
+    // Loads vocabulary into Trie (or its succinct read-only form)
+    cout << "Loading vocabulary into "
+         << (this->autocompleteMode == AUTOCOMPLETE_LOUDS        ? "LOUDS trie"
+             : this->autocompleteMode == AUTOCOMPLETE_CONCURRENT ? "concurrent Trie"
+                                                                 : "Trie")
+         << "..." << endl;
+    Trace::Request traceRequest("HttpRequestHandler::loadVocabularyIntoTrie");
+    if (this->autocompleteMode == AUTOCOMPLETE_TRIE)
+        trie = new Trie();
     if (loadVocabularyIntoTrie()) {
         cout << "Vocabulary loaded successfully." << endl;
     } else {
         cout << "Failed to load vocabulary." << endl;
     }
+
+    // New words reach /predict without a restart
+    if (this->autocompleteMode == AUTOCOMPLETE_CONCURRENT)
+        vocabularyFollower = thread(&HttpRequestHandler::followVocabulary, this);
 }
 
 bool HttpRequestHandler::loadVocabularyIntoTrie() {
-    this->vocabTableName = this->imagemode ? "images_vocab" : "webpage_vocab";
-    const char* vocabFile = this->imagemode ? "images_vocab.db" : "index_vocab.db";
-
-    // Pointer for read statement
-    sqlite3_stmt* stmt;
-    // Statement structure
-    string sql = string("SELECT vocabulary FROM ") + vocabTableName;
+    IndexNames names = getIndexNames(this->imagemode);
+    this->vocabTableName = names.vocabTable;
+    const char* vocabFile = names.vocabFile;
 
     // Opens vocabulary database
     if (sqlite3_open(vocabFile, &database_vocab) != SQLITE_OK) {
@@ -100,58 +300,161 @@ bool HttpRequestHandler::loadVocabularyIntoTrie() {
         cout << "Search mode: " << (this->imagemode ? "IMAGES" : "HTML") << endl;
     }
 
-    // Compiles SQL statement
-    if (sqlite3_prepare_v2(database_vocab, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
-        cerr << "Failed to prepare statement: " << sqlite3_errmsg(database_vocab) << endl;
-        return false;
+    // Reads every word first, then builds first-letter subtries in parallel
+    auto readStart = chrono::steady_clock::now();
+    vector<u32string> words;
+    bool success = readNewVocabulary(
+        database_vocab, vocabTableName, vocabRowid, [&](const u32string& word) {
+            words.push_back(word);
+        });
+
+    auto buildStart = chrono::steady_clock::now();
+    vector<string> sortedWords;
+    if (autocompleteMode == AUTOCOMPLETE_LOUDS || infixSuggestions) {
+        // Level-order build and suffix array need sorted, unique UTF-8 words
+        wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+        sortedWords.reserve(words.size());
+        for (auto& word : words)
+            sortedWords.push_back(converter.to_bytes(word));
+        sort(sortedWords.begin(), sortedWords.end());
+        sortedWords.erase(unique(sortedWords.begin(), sortedWords.end()), sortedWords.end());
     }
-
-    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
-    uint32_t words = 0;
-    u32string content;
-    u32string word;
-    word.reserve(20);
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        content.clear();
-        word.clear();
-        content = converter.from_bytes((char*)sqlite3_column_text(stmt, 0));
-
-        if (content.size() > 0) {
-            for (char32_t c : content) {
-                if (u_isalpha(c)) {
-                    // Builds word character by character
-                    word.push_back(u_tolower(c));
-                } else if (word.size() >= 5) {
-                    // Inserts word into Trie once a non-word character is found
-                    trie->insert(word);
-                    word.clear();
-                    words++;
-                    if (words % 1000 == 0) {
-                        cout << "Words inserted: " << words << endl;
-                    }
-                }
-            }
-            if (word.size() >= 5) {
-                // Inserts last word if applicable
-                trie->insert(word);
-                word.clear();
-                words++;
-            }
-        }
+    if (autocompleteMode == AUTOCOMPLETE_LOUDS) {
+        loudsTrie.build(sortedWords);
+        cout << "LOUDS trie: " << loudsTrie.getNodeCount() << " nodes, "
+             << loudsTrie.getMemoryUsage() / 1024 << " KB" << endl;
+    } else if (autocompleteMode == AUTOCOMPLETE_TRIE) {
+        trie->insertParallel(words);
+    } else if (autocompleteMode == AUTOCOMPLETE_CONCURRENT) {
+        concurrentTrie.insertBatch(words);
     }
-
-    sqlite3_finalize(stmt);
-    cout << "Total words inserted: " << words << endl;
+    if (infixSuggestions) {
+        substringIndex.build(sortedWords);
+        cout << "Suffix array: " << substringIndex.getWordCount() << " words, "
+             << substringIndex.getMemoryUsage() / 1024 << " KB" << endl;
+    }
+    auto buildEnd = chrono::steady_clock::now();
+    recordLoadTime("vocabularyRead", readStart, buildStart);
+    recordLoadTime("vocabularyBuild", buildStart, buildEnd);
+
+    cout << "Total words inserted: " << words.size() << " (read "
+         << chrono::duration_cast<chrono::milliseconds>(buildStart - readStart).count()
+         << " ms, built "
+         << chrono::duration_cast<chrono::milliseconds>(buildEnd - buildStart).count()
+         << " ms on " << max(1U, thread::hardware_concurrency()) << " threads)" << endl;
+
+    // The connection is closed from here on, so /admin/stats reports it as of now
+    vocabDatabaseStatus = databaseStatusJson(database_vocab);
     sqlite3_close(database_vocab);
     cout << "Vocabulary closed" << endl;
-    return true;
+    return success;
+}
+
+chrono::steady_clock::time_point HttpRequestHandler::recordLoadTime(
+    const char* phase,
+    chrono::steady_clock::time_point start,
+    chrono::steady_clock::time_point end) {
+    loadTimes.emplace_back(phase, chrono::duration<double, milli>(end - start).count());
+    return end;
+}
+
+void HttpRequestHandler::loadBigrams(const IndexNames& names) {
+    sqlite3* vocabDatabase;
+    if (sqlite3_open_v2(names.vocabFile, &vocabDatabase, SQLITE_OPEN_READONLY, nullptr) !=
+        SQLITE_OK) {
+        sqlite3_close(vocabDatabase);
+        return;
+    }
+
+    // Rows come most frequent first for each word
+    size_t bigramCount = 0;
+    bool success = readBigrams(
+        vocabDatabase, names.bigramTable, [&](const string& first, const string& second, uint32_t) {
+            bigramFollowers[first].push_back(second);
+            bigramCount++;
+        });
+    sqlite3_close(vocabDatabase);
+
+    if (success)
+        cout << "Bigrams loaded: " << bigramCount << " for " << bigramFollowers.size() << " words"
+             << endl;
+    else
+        cout << "No bigram table, /predict ranks by prefix only" << endl;
+}
+
+void HttpRequestHandler::loadPhrases(const IndexNames& names) {
+    sqlite3* vocabDatabase;
+    if (sqlite3_open_v2(names.vocabFile, &vocabDatabase, SQLITE_OPEN_READONLY, nullptr) !=
+        SQLITE_OK) {
+        sqlite3_close(vocabDatabase);
+        return;
+    }
+
+    vector<pair<string, uint32_t>> phrases;
+    bool success =
+        readPhrases(vocabDatabase, names.phraseTable, [&](const string& phrase, uint32_t count) {
+            phrases.emplace_back(phrase, count);
+        });
+    sqlite3_close(vocabDatabase);
+
+    if (!success) {
+        cout << "No phrase table, /predict completes single words only" << endl;
+        return;
+    }
+    phraseCompleter.build(move(phrases));
+    cout << "Phrases loaded: " << phraseCompleter.size() << ", "
+         << phraseCompleter.getMemoryUsage() / 1024 << " KB" << endl;
+}
+
+// How often the concurrent Trie checks for new vocabulary rows
+static const chrono::seconds VOCABULARY_POLL_INTERVAL(2);
+
+/**
+ * @brief Inserts the vocabulary rows appended since the last poll
+ *
+ * Runs on its own thread with its own connection; inserts never block
+ * /predict, which reads the concurrent Trie lock-free.
+ */
+void HttpRequestHandler::followVocabulary() {
+    IndexNames names = getIndexNames(imagemode);
+    sqlite3* vocabDatabase = nullptr;
+    if (sqlite3_open_v2(names.vocabFile, &vocabDatabase, SQLITE_OPEN_READONLY, nullptr) !=
+        SQLITE_OK) {
+        cerr << "Error opening " << names.vocabFile << " to follow: "
+             << sqlite3_errmsg(vocabDatabase) << endl;
+        sqlite3_close(vocabDatabase);
+        return;
+    }
+
+    unique_lock<mutex> lock(followerLock);
+    while (!followerWake.wait_for(lock, VOCABULARY_POLL_INTERVAL, [&] { return stopping; })) {
+        vector<u32string> words;
+        readNewVocabulary(vocabDatabase, names.vocabTable, vocabRowid, [&](const u32string& word) {
+            words.push_back(word);
+        });
+        if (words.empty())
+            continue;
+
+        size_t inserted = concurrentTrie.insertBatch(words);
+        cout << "Vocabulary follower: " << inserted << " new words ("
+             << concurrentTrie.getWordCount() << " total)" << endl;
+    }
+    sqlite3_close(vocabDatabase);
 }
 
 /**
  * @brief Destroys Handler once no longer used
  */
 HttpRequestHandler::~HttpRequestHandler() {
+    if (vocabularyFollower.joinable()) {
+        {
+            lock_guard<mutex> guard(followerLock);
+            stopping = true;
+        }
+        followerWake.notify_all();
+        vocabularyFollower.join();
+    }
+
     if (database) {
         sqlite3_close(database);
         cout << "Database closed" << endl;
@@ -159,6 +462,51 @@ HttpRequestHandler::~HttpRequestHandler() {
 
     delete trie;
     cout << "Trie deleted" << endl;
+
+#ifdef __linux__
+    if (homeRootFd >= 0)
+        close(homeRootFd);
+#endif
+}
+
+/**
+ * @brief Normalizes a request path lexically in a single pass
+ *
+ * Empty and "." segments are dropped; ".." segments, backslashes and
+ * NUL bytes are rejected, so the result always stays beneath the root.
+ *
+ * @param url The URL (starting with '/')
+ * @param relativePath Normalized path relative to the www root
+ * @return true Path is safe
+ * @return false Path tries to escape the www root
+ */
+bool HttpRequestHandler::normalizeRequestPath(const string& url, string& relativePath) {
+    relativePath.clear();
+    relativePath.reserve(url.size());
+
+    size_t segmentStart = 0;
+    for (size_t i = 0; i <= url.size(); i++) {
+        char c = (i < url.size()) ? url[i] : '/';
+        if (c == '\\' || c == '\0')
+            return false;
+        if (c != '/')
+            continue;
+
+        size_t segmentSize = i - segmentStart;
+        const char* segment = url.data() + segmentStart;
+        segmentStart = i + 1;
+
+        if (segmentSize == 0 || (segmentSize == 1 && segment[0] == '.'))
+            continue;
+        if (segmentSize == 2 && segment[0] == '.' && segment[1] == '.')
+            return false;
+
+        if (!relativePath.empty())
+            relativePath += '/';
+        relativePath.append(segment, segmentSize);
+    }
+
+    return !relativePath.empty();
 }
 
 /**
@@ -170,35 +518,89 @@ HttpRequestHandler::~HttpRequestHandler() {
  * @return false URL invalid
  */
 bool HttpRequestHandler::serve(string url, vector<char>& response) {
+    TRACE_SPAN("HttpRequestHandler::serve");
+
     // Blocks directory traversal
     // e.g. https://www.example.com/show_file.php?file=../../MyFile
-    // * Builds absolute local path from url
-    // * Checks if absolute local path is within home path
-
-    auto homeAbsolutePath = filesystem::absolute(homePath);
-    cout << "Home absolute: " << homeAbsolutePath << endl;
-
-    auto relativePath = homeAbsolutePath / url.substr(1);
-    cout << "Relative path: " << relativePath << endl;
-
-    string path = filesystem::absolute(relativePath.make_preferred()).string();
-    cout << "Final path: " << path << endl;
-    cout << "File exists: " << filesystem::exists(path) << endl;
+    // * Normalizes url lexically, rejecting ".." segments
+    // * Opens the file beneath the pre-opened home directory
 
-    // Security check: prevent directory traversal
-    if (path.substr(0, homeAbsolutePath.string().size()) != homeAbsolutePath) {
+    string relativePath;
+    if (!normalizeRequestPath(url, relativePath)) {
         cout << "SECURITY: Path outside home directory" << endl;
         return false;
     }
 
-    // Check if file exists before trying to open
-    if (!filesystem::exists(path)) {
-        cout << "ERROR: File does not exist at: " << path << endl;
+#ifdef __linux__
+    if (homeRootFd >= 0) {
+        int fd = -1;
+        errno = ENOSYS;
+#if defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+        // Kernel enforces the path never resolves outside the root (symlinks included)
+        struct open_how how = {};
+        how.flags = O_RDONLY | O_CLOEXEC;
+        how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+
+        fd = (int)syscall(SYS_openat2, homeRootFd, relativePath.c_str(), &how, sizeof(how));
+#endif
+        // Kernels or headers older than 5.6, or seccomp filters that reject the
+        // syscall with EPERM: only the lexical check above applies
+        if (fd < 0 && (errno == ENOSYS || errno == EPERM)) {
+            static once_flag warning;
+            call_once(warning, [] {
+                cerr << "warning: openat2 unavailable, symlinks may lead outside the home "
+                        "directory"
+                     << endl;
+            });
+            fd = openat(homeRootFd, relativePath.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (fd < 0) {
+            if (errno == EXDEV)
+                cout << "SECURITY: Path outside home directory" << endl;
+            else
+                cout << "ERROR: Failed to open file: " << relativePath << endl;
+            return false;
+        }
+
+        // Check if it's a regular file
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+            cout << "ERROR: Not a regular file: " << relativePath << endl;
+            close(fd);
+            return false;
+        }
+
+        // Serves file
+        response.resize(fileStat.st_size);
+        size_t bytesRead = 0;
+        while (bytesRead < response.size()) {
+            ssize_t result = read(fd, response.data() + bytesRead, response.size() - bytesRead);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                break;
+            bytesRead += result;
+        }
+        close(fd);
+        response.resize(bytesRead);
+
+        return true;
+    }
+#endif
+
+    // A root name such as "C:" replaces the root in operator/, so the joined
+    // path must still lie beneath it
+    filesystem::path path =
+        (homeRootPath / filesystem::path(relativePath).make_preferred()).lexically_normal();
+    filesystem::path root = homeRootPath.has_filename() ? homeRootPath : homeRootPath.parent_path();
+    if (mismatch(root.begin(), root.end(), path.begin(), path.end()).first != root.end()) {
+        cout << "ERROR: Path outside home directory: " << path << endl;
         return false;
     }
 
     // Check if it's a regular file
-    if (!filesystem::is_regular_file(path)) {
+    error_code error;
+    if (!filesystem::is_regular_file(path, error)) {
         cout << "ERROR: Not a regular file: " << path << endl;
         return false;
     }
@@ -220,192 +622,8 @@ bool HttpRequestHandler::serve(string url, vector<char>& response) {
     return true;
 }
 
-/**
- * @brief URL encodes a string (replaces spaces and special characters)
- *
- * @param str Input string
- * @return URL-encoded string
- */
-string urlEncode(const string& str) {
-    ostringstream encoded;
-    encoded.fill('0');
-    encoded << hex;
-
-    for (unsigned char c : str) {
-        // Keep alphanumeric and safe characters
-        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
-            encoded << c;
-        }
-        // Space becomes %20
-        else if (c == ' ') {
-            encoded << "%20";
-        }
-        // Other characters are percent-encoded
-        else {
-            encoded << uppercase;
-            encoded << '%' << setw(2) << int((unsigned char)c);
-            encoded << nouppercase;
-        }
-    }
-
-    return encoded.str();
-}
-
-/**
- * @brief Cleans HTML content to extract readable text
- *
- * @param html Raw HTML content
- * @return Cleaned text without tags
- */
-string cleanHtmlContent(const string& html) {
-    string result = html;
-
-    // Remove script tags and their content
-    regex scriptRegex("<script[^>]*>.*?</script>", regex::icase);
-    result = regex_replace(result, scriptRegex, " ");
-
-    // Remove style tags and their content
-    regex styleRegex("<style[^>]*>.*?</style>", regex::icase);
-    result = regex_replace(result, styleRegex, " ");
-
-    // Remove all HTML tags
-    regex tagRegex("<[^>]*>");
-    result = regex_replace(result, tagRegex, " ");
-
-    // Replace multiple spaces with single space
-    regex spaceRegex("\\s+");
-    result = regex_replace(result, spaceRegex, " ");
-
-    // Trim leading and trailing spaces
-    size_t start = result.find_first_not_of(" \t\n\r");
-    size_t end = result.find_last_not_of(" \t\n\r");
-
-    if (start == string::npos || end == string::npos) {
-        return "";
-    }
-
-    return result.substr(start, end - start + 1);
-}
-
-/**
- * @brief Generates a snippet from HTML file content
- *
- * @param filePath Path to the HTML file
- * @param maxWords Maximum number of words in snippet
- * @return Snippet text with ellipsis if truncated
- */
-string generateSnippet(const string& filePath, int maxWords = 30) {
-    ifstream file(filePath);
-    if (!file.is_open()) {
-        return "";
-    }
-
-    // Read entire file
-    stringstream buffer;
-    buffer << file.rdbuf();
-    string content = buffer.str();
-    file.close();
-
-    // Clean HTML content
-    string cleanText = cleanHtmlContent(content);
-
-    if (cleanText.empty()) {
-        return "";
-    }
-
-    // Extract first N words
-    istringstream iss(cleanText);
-    string word;
-    vector<string> words;
-
-    while (iss >> word && words.size() < maxWords) {
-        words.push_back(word);
-    }
-
-    if (words.empty()) {
-        return "";
-    }
-
-    // Join words
-    string snippet;
-    for (size_t i = 0; i < words.size(); i++) {
-        snippet += words[i];
-        if (i < words.size() - 1) {
-            snippet += " ";
-        }
-    }
-
-    // Add ellipsis if there are more words
-    bool hasMore = false;
-    if (iss >> word) {
-        hasMore = true;
-    }
-
-    if (hasMore || words.size() == maxWords) {
-        snippet += "...";
-    }
-
-    return snippet;
-}
-
-/**
- * @brief Converts filename to title case
- *
- * @param filename Input filename
- * @return Cleaned and formatted title
- */
-string cleanTitle(const string& filename) {
-    string result = filename;
-
-    // Replace underscores with spaces
-    replace(result.begin(), result.end(), '_', ' ');
-
-    // Remove parentheses and their content
-    regex parenRegex("\\([^)]*\\)");
-    result = regex_replace(result, parenRegex, "");
-
-    // Trim spaces
-    size_t start = result.find_first_not_of(" \t");
-    size_t end = result.find_last_not_of(" \t");
-
-    if (start != string::npos && end != string::npos) {
-        result = result.substr(start, end - start + 1);
-    }
-
-    // Capitalize first letter of each word (simple title case)
-    bool capitalizeNext = true;
-    for (size_t i = 0; i < result.length(); i++) {
-        if (capitalizeNext && isalpha(result[i])) {
-            result[i] = toupper(result[i]);
-            capitalizeNext = false;
-        } else if (result[i] == ' ') {
-            capitalizeNext = true;
-        }
-    }
-
-    return result;
-}
-
-/**
- * @brief Cleans URL for display (removes leading slash)
- *
- * @param url Input URL
- * @return Cleaned URL
- */
-string cleanUrl(const string& url) {
-    if (url.empty()) {
-        return url;
-    }
-
-    // Remove leading slash
-    if (url[0] == '/') {
-        return url.substr(1);
-    }
-
-    return url;
-}
-
 bool HttpRequestHandler::luckyHandler(vector<char>& response) {
+    TRACE_SPAN("HttpRequestHandler::luckyHandler");
     cout << "Lucky search request received" << endl;
 
     if (!database) {
@@ -451,29 +669,105 @@ bool HttpRequestHandler::luckyHandler(vector<char>& response) {
 }
 
 bool HttpRequestHandler::predictHandler(std::vector<char>& response, HttpArguments& arguments) {
+    TRACE_SPAN("HttpRequestHandler::predictHandler");
     cout << "Predict request received" << endl;
     string query;
     if (arguments.find("q") != arguments.end())
         query = arguments["q"];
     cout << "Query: " << query << endl;
 
-    // Clear previous suggestions and collect new ones
-    trie->collectWords.clear();
-    size_t numSuggestions = trie->collectSuggestions(query, 10);
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+    u32string query32 = QueryCompiler::decode(query);
+    for (char32_t& c : query32)
+        c = u_tolower(c);
+    string loweredQuery = converter.to_bytes(query32);
+
+    // Byte offsets of the typed tokens; lowercasing keeps them for Latin text,
+    // and phrases only ever match lowercased letters
+    vector<size_t> tokenStarts;
+    for (size_t i = 0; i < query.size(); i++) {
+        bool space = query[i] == ' ' || query[i] == '\t';
+        bool previousSpace = i == 0 || query[i - 1] == ' ' || query[i - 1] == '\t';
+        if (!space && previousSpace)
+            tokenStarts.push_back(i);
+    }
 
-    // Build response
-    string jsonResponse = "[";
+    vector<string> suggestions;
+    auto addSuggestion = [&](const string& suggestion) {
+        if (suggestions.size() < 10 &&
+            find(suggestions.begin(), suggestions.end(), suggestion) == suggestions.end())
+            suggestions.push_back(suggestion);
+    };
+
+    // Phrases continuing the last words typed rank first; the longest match wins,
+    // so "arbol bin" completes "arbol binario" before "binario" alone
+    if (phraseCompleter.size() && loweredQuery.size() == query.size()) {
+        bool trailingSpace = !query.empty() && (query.back() == ' ' || query.back() == '\t');
+        vector<string> phrases;
+        for (size_t words = min<size_t>(3, tokenStarts.size()); words > 0 && phrases.empty();
+             words--) {
+            size_t phraseStart = tokenStarts[tokenStarts.size() - words];
+            string prefix;
+            for (size_t i = tokenStarts.size() - words; i < tokenStarts.size(); i++) {
+                size_t end = loweredQuery.find_first_of(" \t", tokenStarts[i]);
+                if (!prefix.empty())
+                    prefix += ' ';
+                prefix += loweredQuery.substr(tokenStarts[i], end - tokenStarts[i]);
+            }
+            if (trailingSpace)
+                prefix += ' ';
 
-    // Converts suggestions to JSON array
-    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+            phraseCompleter.collectSuggestions(prefix, PHRASE_SUGGESTIONS, phrases);
+            for (const string& phrase : phrases)
+                addSuggestion(query.substr(0, phraseStart) + phrase);
+        }
+    }
 
-    for (size_t i = 0; i < trie->collectWords.size(); i++) {
-        // Converts UTF-32 word back to UTF-8
-        string suggestion = converter.to_bytes(trie->collectWords[i]);
+    // Completes only the last token; the words before it are returned as typed
+    size_t tokenStart = query.find_last_of(" \t");
+    tokenStart = tokenStart == string::npos ? 0 : tokenStart + 1;
+    string head = query.substr(0, tokenStart);
+
+    u32string token32 = QueryCompiler::decode(query.substr(tokenStart));
+    for (char32_t& c : token32)
+        c = u_tolower(c);
+    string token = converter.to_bytes(token32);
+
+    // Previous vocabulary word, tokenized as mkindex counted the bigrams
+    u32string previousWord;
+    forEachWord(QueryCompiler::decode(head), [&](const u32string& word) { previousWord = word; });
+
+    // Words that followed the previous one in the corpus come next
+    auto followers = bigramFollowers.find(converter.to_bytes(previousWord));
+    if (followers != bigramFollowers.end()) {
+        for (const string& follower : followers->second) {
+            if (follower.compare(0, token.size(), token) == 0)
+                addSuggestion(head + follower);
+        }
+    }
 
-        jsonResponse += "\"" + suggestion + "\"";
+    // Collects completions from the automaton or the Trie
+    vector<string> completions;
+    if (!token.empty())
+        collectCompletions(token32, 10, completions);
 
-        if (i < trie->collectWords.size() - 1) {
+    // Fills the remaining slots with words containing the token elsewhere
+    if (infixSuggestions && !token.empty() && completions.size() < 10)
+        substringIndex.collectInfixSuggestions(token, 10 - completions.size(), completions);
+
+    for (const string& completion : completions)
+        addSuggestion(head + completion);
+
+    // Build response
+    string jsonResponse = "[";
+
+    // Converts full query strings to JSON array
+    for (size_t i = 0; i < suggestions.size(); i++) {
+        jsonResponse += "\"";
+        appendJsonEscaped(jsonResponse, suggestions[i]);
+        jsonResponse += "\"";
+
+        if (i < suggestions.size() - 1) {
             jsonResponse += ",";
         }
     }
@@ -484,6 +778,30 @@ bool HttpRequestHandler::predictHandler(std::vector<char>& response, HttpArgumen
     return true;
 }
 
+void HttpRequestHandler::collectCompletions(const u32string& token,
+                                            size_t maxSuggestions,
+                                            vector<string>& completions) {
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+    if (autocompleteMode == AUTOCOMPLETE_DAWG) {
+        dawg.collectSuggestions(converter.to_bytes(token), maxSuggestions, completions);
+    } else if (autocompleteMode == AUTOCOMPLETE_LOUDS) {
+        loudsTrie.collectSuggestions(converter.to_bytes(token), maxSuggestions, completions);
+    } else if (autocompleteMode == AUTOCOMPLETE_CONCURRENT) {
+        vector<u32string> words;
+        concurrentTrie.collectSuggestions(token, maxSuggestions, words);
+        for (auto& word : words)
+            completions.push_back(converter.to_bytes(word));
+    } else if (trie) {
+        // Shortest first, so a deep branch of long words cannot crowd out short ones
+        vector<u32string> words;
+        trie->collectSuggestions(token, maxSuggestions, words, SUGGEST_SHORTEST_FIRST);
+
+        // Converts UTF-32 words back to UTF-8
+        for (auto& word : words)
+            completions.push_back(converter.to_bytes(word));
+    }
+}
+
 bool HttpRequestHandler::homePageHandler(std::vector<char>& response) {
     // Serves the home page with autocomplete functionality
     string responseString = Responses::homePageResponse();
@@ -531,54 +849,303 @@ bool HttpRequestHandler::imageHandler(std::vector<char>& response,
     return serve(url, response);
 }
 
-bool HttpRequestHandler::searchHandler(std::vector<char>& response, HttpArguments& arguments) {
+/**
+ * @brief One row of the search results
+ */
+struct SearchResult {
+    string path;
+    string snippet;
+    // Image index only
+    ImageInfo image;
+    string thumbnail;
+};
+
+/**
+ * @brief What the search for one MATCH expression found
+ */
+struct SearchRows {
+    vector<SearchResult> results;
+    // Ranking ran out of time, results are the first matches instead
+    bool partial = false;
+    int64_t hitCount = 0;
+    bool exactHits = true;
+};
+
+/**
+ * @brief Runs a compiled MATCH expression and appends up to SEARCH_RESULTS rows
+ *
+ * Ranking sorts every match before returning the first row, so an
+ * interrupted ranked search yields nothing; unranked, rows come in rowid
+ * order and those read before an interruption are kept.
+ *
+ * @param ranked True for the best rows by BM25, false for the first ones
+ * @return SQLITE_DONE if the search finished, otherwise the SQLite error
+ *         (SQLITE_INTERRUPT when the search budget ran out)
+ */
+static int runSearch(sqlite3* database,
+                     const char* tableName,
+                     bool imagemode,
+                     const string& matchExpression,
+                     bool ranked,
+                     vector<SearchResult>& results) {
+    sqlite3_stmt* stmt;
+    // The image index also stores header metadata and the thumbnail path
+    string columns = imagemode ? "path, snippet, width, height, bytes, format, thumbnail"
+                               : "path, snippet";
+    // BM25 counts the documents of every term up front, even for one row
+    string rank = ranked ? string(", BM25(") + tableName + ") AS rank " : " ";
+    string order = ranked ? " ORDER BY rank ASC" : "";
+    string sql = "SELECT " + columns + rank + "FROM " + tableName + " WHERE " + tableName +
+                 " MATCH ?" + order + " LIMIT " + to_string(SEARCH_RESULTS) + ";";
+
+    int prepareResult;
+    {
+        TRACE_SPAN("sqlite3_prepare_v2");
+        prepareResult = sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL);
+
+        // Image indexes built before these columns existed
+        if (prepareResult != SQLITE_OK && imagemode) {
+            sql = "SELECT path, snippet" + rank + "FROM " + tableName + " WHERE " + tableName +
+                  " MATCH ?" + order + " LIMIT " + to_string(SEARCH_RESULTS) + ";";
+            prepareResult = sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL);
+        }
+    }
+
+    if (prepareResult != SQLITE_OK)
+        return prepareResult;
+
+    int stepResult;
+    {
+        TRACE_SPAN("sqlite3_step");
+        sqlite3_bind_text(stmt, 1, matchExpression.c_str(), -1, SQLITE_TRANSIENT);
+
+        bool hasImageInfo = sqlite3_column_count(stmt) >= 7;
+
+        while ((stepResult = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const char* path = (const char*)sqlite3_column_text(stmt, 0);
+            const char* snippet = (const char*)sqlite3_column_text(stmt, 1);
+
+            if (path) {
+                SearchResult result;
+                result.path = path;
+                result.snippet = snippet ? string(snippet) : "";
+
+                if (hasImageInfo) {
+                    const char* format = (const char*)sqlite3_column_text(stmt, 5);
+                    const char* thumbnail = (const char*)sqlite3_column_text(stmt, 6);
+                    result.image.width = (uint32_t)sqlite3_column_int64(stmt, 2);
+                    result.image.height = (uint32_t)sqlite3_column_int64(stmt, 3);
+                    result.image.bytes = (uint64_t)sqlite3_column_int64(stmt, 4);
+                    result.image.format = format ? format : "";
+                    result.thumbnail = thumbnail ? thumbnail : "";
+                }
+
+                results.push_back(result);
+            }
+        }
+
+        sqlite3_finalize(stmt);
+    }
+
+    return stepResult;
+}
+
+/**
+ * @brief Runs identical concurrent searches once
+ *
+ * A shared link brings many requests for the same search at once. The
+ * first one searches; the others wait for its rows instead of ranking the
+ * same matches again, and render their own page. The key is the compiled
+ * expression, so texts differing only in case, accents, spacing or
+ * stopwords share one search. Finished searches leave the table, so there
+ * is no caching.
+ *
+ * @param key Compiled expression, prefixed by exact
+ * @param search Runs the search; returns null if it was cancelled
+ * @return The rows, null if this request's own search was cancelled
+ */
+shared_ptr<const SearchRows> HttpRequestHandler::coalesceSearch(
+    const string& key, const function<shared_ptr<const SearchRows>()>& search) {
+    promise<shared_ptr<const SearchRows>> rows;
+    shared_future<shared_ptr<const SearchRows>> pending;
+    bool first;
+    {
+        lock_guard<mutex> lock(searchesLock);
+        auto running = searchesInFlight.find(key);
+        first = running == searchesInFlight.end();
+        if (first) {
+            pending = rows.get_future().share();
+            searchesInFlight.emplace(key, pending);
+        } else {
+            pending = running->second;
+            coalescedSearches++;
+        }
+    }
+
+    if (!first) {
+        shared_ptr<const SearchRows> shared;
+        {
+            TRACE_SPAN("HttpRequestHandler::awaitSearch");
+            shared = pending.get();
+        }
+
+        // The first client hung up before its search finished
+        return shared ? shared : search();
+    }
+
+    // Requests arriving after this point search again
+    auto publish = [&](shared_ptr<const SearchRows> found) {
+        {
+            lock_guard<mutex> lock(searchesLock);
+            searchesInFlight.erase(key);
+        }
+        rows.set_value(found);
+    };
+
+    shared_ptr<const SearchRows> found;
+    try {
+        found = search();
+    } catch (...) {
+        publish(nullptr);
+        throw;
+    }
+    publish(found);
+    return found;
+}
+
+bool HttpRequestHandler::searchHandler(std::vector<char>& response,
+                                       HttpArguments& arguments,
+                                       const ClientProbe& isClientGone) {
+    TRACE_SPAN("HttpRequestHandler::searchHandler");
     string searchString;
     if (arguments.find("q") != arguments.end())
         searchString = arguments["q"];
 
     // HTML Header with autocomplete and enhanced styling
-    string responseString = Responses::searchPageStart(searchString);
+    string responseString = Responses::searchPageStart(htmlEscape(searchString));
 
     // Start timer
     auto startTime = chrono::high_resolution_clock::now();
     float searchTime = 0.0F;
-    vector<pair<string, string>> results;
-
-    if (!searchString.empty() && database) {
-        sqlite3_stmt* stmt;
-        string sql = string("SELECT path, snippet, BM25(") + tableName + ") AS rank " + "FROM " +
-                     tableName + " WHERE " + tableName + " MATCH ? ORDER BY rank ASC LIMIT 100;";
-
-        if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, searchString.c_str(), -1, SQLITE_TRANSIENT);
-
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                const char* path = (const char*)sqlite3_column_text(stmt, 0);
-                const char* snippet = (const char*)sqlite3_column_text(stmt, 1);
 
-                if (path) {
-                    string snippetStr = snippet ? string(snippet) : "";
-                    results.push_back(make_pair(string(path), snippetStr));
-                }
-            }
-
-            sqlite3_finalize(stmt);
+    // Quotes, hyphens and colons typed by users are not FTS5 syntax; the
+    // compiled expression also rules out terms no document contains
+    string matchExpression;
+    QueryStats queryStats;
+    auto compile = [&](const string& text) {
+        return queryCompiler.compile(
+            text,
+            matchExpression,
+            [&](const u32string& prefix, size_t limit) {
+                vector<string> expansions;
+                collectCompletions(prefix, limit + 1, expansions);
+                return expansions.size();
+            },
+            &queryStats);
+    };
+
+    // Common terms and wide prefixes can keep BM25 ranking busy for seconds:
+    // past the deadline the first matches are listed unranked instead
+    SearchBudget budget(searchTimeout, isClientGone);
+    auto runRows = [&]() -> shared_ptr<const SearchRows> {
+        auto rows = make_shared<SearchRows>();
+        vector<SearchResult>& results = rows->results;
+        if (runSearch(database, tableName, imagemode, matchExpression, true, results) ==
+                SQLITE_INTERRUPT &&
+            !budget.clientGone) {
+            rows->partial = true;
+            budget.extend(PARTIAL_SEARCH_TIMEOUT);
+            runSearch(database, tableName, imagemode, matchExpression, false, results);
+        }
+        if (budget.clientGone)
+            return nullptr;
+
+        // Fewer rows than the limit are all the hits; otherwise they are counted
+        // from the term statistics instead of a second full match
+        rows->hitCount = (int64_t)results.size();
+        if (results.size() == SEARCH_RESULTS || rows->partial) {
+            TRACE_SPAN("QueryCompiler::estimateHits");
+            budget.extend(searchTimeout.count() ? HIT_COUNT_TIMEOUT : searchTimeout);
+            int64_t estimate =
+                queryCompiler.estimateHits(matchExpression, queryStats, rows->exactHits);
+            if (estimate >= 0)
+                rows->hitCount = max(rows->hitCount, estimate);
+            else
+                rows->exactHits = false;
         }
+        return rows;
+    };
+
+    // Identical searches running meanwhile share their rows (see coalesceSearch)
+    static const SearchRows NO_ROWS;
+    string exactKey = arguments.find("exact") == arguments.end() ? "0" : "1";
+    shared_ptr<const SearchRows> rows;
+    auto search = [&]() { rows = coalesceSearch(exactKey + matchExpression, runRows); };
+
+    if (database && compile(searchString))
+        search();
+
+    // Only searches that found nothing look for typos; with -autocorrect the
+    // corrected text is searched right away, unless exact=1 asks otherwise
+    string correction;
+    bool corrected = false;
+    if ((!rows || rows->results.empty()) && !budget.clientGone &&
+        correctSpelling(searchString, correction) && autocorrect &&
+        arguments.find("exact") == arguments.end() && database && compile(correction)) {
+        search();
+        corrected = rows && !rows->results.empty();
     }
 
+    // Nobody is waiting for the page
+    if (budget.clientGone)
+        return false;
+
+    const SearchRows& found = rows ? *rows : NO_ROWS;
+    const vector<SearchResult>& results = found.results;
+    bool partial = found.partial;
+    int64_t hitCount = found.hitCount;
+    bool exactHits = found.exactHits;
+
     // Stop timer
     auto endTime = chrono::high_resolution_clock::now();
     searchTime = chrono::duration<float>(endTime - startTime).count();
 
     // Print search results count
-    responseString += "<div class=\"results-stats\">" + to_string(results.size()) +
+    responseString += "<div class=\"results-stats\">" +
+                      string(exactHits ? "" : "Aproximadamente ") + to_string(hitCount) +
                       " resultados (" + to_string(searchTime) + " segundos)</div>";
 
+    // "Did you mean", or which text the results are for after an autocorrection
+    if (!correction.empty()) {
+        responseString += "<div class=\"spelling\">";
+        responseString += corrected ? "Mostrando resultados de " : "Quizás quisiste decir: ";
+        responseString += "<a href=\"/search?q=";
+        appendUrlEncoded(responseString, correction);
+        responseString += "\">";
+        appendHtmlEscaped(responseString, correction);
+        responseString += "</a>";
+        if (corrected) {
+            responseString += ". Buscar <a href=\"/search?exact=1&amp;q=";
+            appendUrlEncoded(responseString, searchString);
+            responseString += "\">";
+            appendHtmlEscaped(responseString, searchString);
+            responseString += "</a> en su lugar.";
+        }
+        responseString += "</div>";
+    }
+
+    if (partial) {
+        responseString += "<div class=\"partial\">La búsqueda superó el tiempo límite: se "
+                          "muestran las primeras coincidencias, sin ordenar por relevancia."
+                          "</div>";
+    }
+
     responseString += "<div class=\"results\">";
 
+    TRACE_SPAN("HttpRequestHandler::renderResults");
     for (auto& result : results) {
-        string path = result.first;
-        string precomputedSnippet = result.second;
+        string path = result.path;
+        string precomputedSnippet = result.snippet;
 
         // Extract display name from path
         size_t lastSlash = path.find_last_of('/');
@@ -608,29 +1175,65 @@ bool HttpRequestHandler::searchHandler(std::vector<char>& response, HttpArgument
         // Clean URL for display
         string displayUrl = cleanUrl(path);
 
-        // Build result HTML based on mode
+        // Build result HTML based on mode; URLs, titles and snippets are encoded
+        // straight into the response
         if (imagemode) {
             // IMAGE MODE
-            string encodedPath = urlEncode(path);
+            // Thumbnails are much smaller than the originals, which stay behind the link
+            const string& source = result.thumbnail.empty() ? path : result.thumbnail;
+            const ImageInfo& image = result.image;
+
+            // Known dimensions let the browser reserve the box before the image loads
+            string sizeAttributes;
+            if (image.width && image.height) {
+                sizeAttributes = " width=\"" + to_string(image.width) + "\" height=\"" +
+                                 to_string(image.height) + "\"";
+            }
 
             responseString += "<div class=\"result image-result\">";
             responseString += "<div class=\"image-thumbnail\">";
-            responseString += "<a href=\"" + path + "?view=1\"><img src=\"" + encodedPath +
-                              "\" alt=\"" + cleanedTitle + "\"></a>";
+            responseString += "<a href=\"";
+            appendUrlEncoded(responseString, path);
+            responseString += "?view=1\"><img src=\"";
+            appendUrlEncoded(responseString, source);
+            responseString += "\" alt=\"";
+            appendHtmlEscaped(responseString, cleanedTitle);
+            responseString += "\"" + sizeAttributes + " loading=\"lazy\" decoding=\"async\"></a>";
             responseString += "</div>";
             responseString += "<div class=\"image-details\">";
-            responseString += "<div class=\"url\">" + displayUrl + "</div>";
-            responseString +=
-                "<a class=\"title\" href=\"" + path + "?view=1\">" + cleanedTitle + "</a>";
-            responseString += "<div class=\"snippet\">" + snippet + "</div>";
+            responseString += "<div class=\"url\">";
+            appendHtmlEscaped(responseString, displayUrl);
+            responseString += "</div>";
+            responseString += "<a class=\"title\" href=\"";
+            appendUrlEncoded(responseString, path);
+            responseString += "?view=1\">";
+            appendHtmlEscaped(responseString, cleanedTitle);
+            responseString += "</a>";
+            responseString += "<div class=\"snippet\">";
+            appendHtmlEscaped(responseString, snippet);
+            responseString += "</div>";
+            if (image.width && image.height) {
+                responseString += "<div class=\"image-meta\">" + to_string(image.width) +
+                                  " × " + to_string(image.height) + " · ";
+                appendHtmlEscaped(responseString, image.format);
+                responseString += " · " + to_string((image.bytes + 1023) / 1024) + " KB</div>";
+            }
             responseString += "</div>";
             responseString += "</div>";
         } else {
             // HTML MODE
             responseString += "<div class=\"result\">";
-            responseString += "<div class=\"url\">" + displayUrl + "</div>";
-            responseString += "<a class=\"title\" href=\"" + path + "\">" + cleanedTitle + "</a>";
-            responseString += "<div class=\"snippet\">" + snippet + "</div>";
+            responseString += "<div class=\"url\">";
+            appendHtmlEscaped(responseString, displayUrl);
+            responseString += "</div>";
+            responseString += "<a class=\"title\" href=\"";
+            appendUrlEncoded(responseString, path);
+            responseString += "\">";
+            appendHtmlEscaped(responseString, cleanedTitle);
+            responseString += "</a>";
+            responseString += "<div class=\"snippet\">";
+            appendHtmlEscaped(responseString, snippet);
+            responseString += "</div>";
             responseString += "</div>";
         }
     }
@@ -641,18 +1244,172 @@ bool HttpRequestHandler::searchHandler(std::vector<char>& response, HttpArgument
     return true;
 }
 
+bool HttpRequestHandler::correctSpelling(const string& query, string& correction) const {
+    correction.clear();
+    if (!spelling.getWordCount())
+        return false;
+
+    // Terms with postings stay as typed; the rest take the closest index term
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+    bool changed = false;
+    QueryCompiler::tokenize(QueryCompiler::decode(query), [&](const u32string& token) {
+        string word = converter.to_bytes(token);
+        string folded = QueryCompiler::fold(token);
+        string fixed;
+        uint32_t distance;
+        if (!QueryCompiler::isStopword(folded) && queryCompiler.getDocumentCount(folded) <= 0 &&
+            spelling.lookup(folded, fixed, distance) && distance > 0) {
+            word = fixed;
+            changed = true;
+        }
+        correction += (correction.empty() ? "" : " ") + word;
+    });
+    return changed;
+}
+
+bool HttpRequestHandler::statsHandler(std::vector<char>& response) {
+    string json = "{";
+
+    // Autocomplete structures; the Trie is walked node by node
+    static const char* const modeNames[] = {"trie", "dawg", "louds", "concurrent"};
+    json += string("\"autocomplete\": \"") + modeNames[autocompleteMode] + "\"";
+    if (trie) {
+        TrieStats stats = trie->getStats();
+        json += ", \"trie\": {\"nodes\": " + to_string(stats.nodeCount) +
+                ", \"words\": " + to_string(stats.wordCount) +
+                ", \"node4\": " + to_string(stats.nodeTypes[TrieNode::NODE4]) +
+                ", \"node16\": " + to_string(stats.nodeTypes[TrieNode::NODE16]) +
+                ", \"node48\": " + to_string(stats.nodeTypes[TrieNode::NODE48]) +
+                ", \"node256\": " + to_string(stats.nodeTypes[TrieNode::NODE256]) +
+                ", \"nodeBytes\": " + to_string(stats.nodeBytes) +
+                ", \"allocatedBytes\": " + to_string(stats.allocatedBytes) +
+                ", \"alphabetSize\": " + to_string(stats.alphabetSize) +
+                ", \"alphabetBytes\": " + to_string(stats.alphabetBytes) + ", \"bytesPerWord\": " +
+                to_string(stats.wordCount ? (double)(stats.allocatedBytes + stats.alphabetBytes) /
+                                                stats.wordCount
+                                          : 0) +
+                ", \"averageDepth\": " + to_string(stats.averageDepth) +
+                ", \"maxDepth\": " + to_string(stats.maxDepth) + ", \"fanout\": [";
+        for (size_t depth = 0; depth < stats.fanout.size(); depth++) {
+            json += depth ? ", {" : "{";
+            for (size_t bucket = 0; bucket < TrieStats::FANOUT_BUCKETS; bucket++) {
+                json += bucket ? ", \"" : "\"";
+                json += string(TrieStats::fanoutLabel(bucket)) + "\": " +
+                        to_string(stats.fanout[depth][bucket]);
+            }
+            json += "}";
+        }
+        json += "]}";
+    }
+    if (dawg.getWordCount())
+        json += ", \"dawg\": {\"words\": " + to_string(dawg.getWordCount()) +
+                ", \"states\": " + to_string(dawg.getStateCount()) +
+                ", \"bytes\": " + to_string(dawg.getMemoryUsage()) + "}";
+    if (loudsTrie.getWordCount())
+        json += ", \"louds\": {\"words\": " + to_string(loudsTrie.getWordCount()) +
+                ", \"nodes\": " + to_string(loudsTrie.getNodeCount()) +
+                ", \"bytes\": " + to_string(loudsTrie.getMemoryUsage()) + "}";
+    if (autocompleteMode == AUTOCOMPLETE_CONCURRENT)
+        json += ", \"concurrentTrie\": {\"words\": " + to_string(concurrentTrie.getWordCount()) +
+                ", \"pendingReclaim\": " + to_string(concurrentTrie.getPendingReclaim()) + "}";
+    if (substringIndex.getWordCount())
+        json += ", \"substringIndex\": {\"words\": " + to_string(substringIndex.getWordCount()) +
+                ", \"bytes\": " + to_string(substringIndex.getMemoryUsage()) + "}";
+    json += ", \"phrases\": {\"count\": " + to_string(phraseCompleter.size()) +
+            ", \"bytes\": " + to_string(phraseCompleter.getMemoryUsage()) + "}";
+    json += ", \"bigramWords\": " + to_string(bigramFollowers.size());
+    json += ", \"spelling\": {\"words\": " + to_string(spelling.getWordCount()) +
+            ", \"mappedBytes\": " + to_string(spelling.getMappedSize()) + "}";
+    {
+        lock_guard<mutex> lock(searchesLock);
+        json += ", \"searches\": {\"inFlight\": " + to_string(searchesInFlight.size()) +
+                ", \"coalesced\": " + to_string(coalescedSearches) + "}";
+    }
+
+    // Startup phases, in milliseconds
+    json += ", \"loadTimesMs\": {";
+    double total = 0;
+    for (size_t i = 0; i < loadTimes.size(); i++) {
+        json += (i ? ", \"" : "\"") + loadTimes[i].first + "\": " + to_string(loadTimes[i].second);
+        total += loadTimes[i].second;
+    }
+    json += string(loadTimes.empty() ? "\"" : ", \"") + "total\": " + to_string(total) + "}";
+
+    // SQLite allocator, process-wide, then each connection
+    sqlite3_int64 memoryUsed = 0, memoryHighwater = 0, mallocCount = 0, highwater = 0;
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &memoryUsed, &memoryHighwater, 0);
+    sqlite3_status64(SQLITE_STATUS_MALLOC_COUNT, &mallocCount, &highwater, 0);
+    json += ", \"sqlite\": {\"memoryUsed\": " + to_string(memoryUsed) +
+            ", \"memoryHighwater\": " + to_string(memoryHighwater) +
+            ", \"mallocCount\": " + to_string(mallocCount) +
+            ", \"indexDatabase\": " + databaseStatusJson(database) +
+            ", \"vocabularyDatabaseAtLoad\": " + vocabDatabaseStatus + "}";
+
+    json += "}";
+    response.assign(json.begin(), json.end());
+    return true;
+}
+
+bool HttpRequestHandler::adminHandler(std::vector<char>& response, std::string& url) {
+    //=============== TRACE DUMP ===============//
+    if (url == "/admin/trace") {
+        string jsonResponse = Trace::dumpJson();
+        response.assign(jsonResponse.begin(), jsonResponse.end());
+        return true;
+    }
+
+    //=============== MEMORY AND SHAPE STATISTICS ===============//
+    if (url == "/admin/stats")
+        return statsHandler(response);
+
+    return false;
+}
+
+void HttpRequestHandler::setAdminEnabled(bool enabled) {
+    adminEnabled = enabled;
+}
+
+void HttpRequestHandler::setAutocorrect(bool enabled) {
+    autocorrect = enabled;
+}
+
+void HttpRequestHandler::setSearchTimeout(chrono::milliseconds timeout) {
+    searchTimeout = timeout;
+}
+
+void HttpRequestHandler::setQueryLog(QueryLog* queryLog) {
+    this->queryLog = queryLog;
+}
+
+void HttpRequestHandler::logQuery(QueryLogRoute route, HttpArguments& arguments) {
+    if (!queryLog)
+        return;
+
+    auto query = arguments.find("q");
+    queryLog->append(route, query != arguments.end() ? query->second : "");
+}
+
 bool HttpRequestHandler::handleRequest(string url,
                                        HttpArguments arguments,
-                                       vector<char>& response) {
+                                       vector<char>& response,
+                                       const ClientProbe& isClientGone) {
+    //=============== ADMIN HANDLER ===============//
+    string adminPage = "/admin/";
+    if (adminEnabled && url.substr(0, adminPage.size()) == adminPage) {
+        return adminHandler(response, url);
+    }
+
     //=============== LUCKY HANDLER (FAST VERSION) ===============//
     string luckyPage = "/lucky";
     if (url == luckyPage) {
+        logQuery(QUERYLOG_LUCKY, arguments);
         return HttpRequestHandler::luckyHandler(response);
     }
 
     //=============== PREDICT HANDLER ===============//
     string predictPage = "/predict";
     if (url.substr(0, predictPage.size()) == predictPage) {
+        logQuery(QUERYLOG_PREDICT, arguments);
         return predictHandler(response, arguments);
     }
 
@@ -668,15 +1425,21 @@ bool HttpRequestHandler::handleRequest(string url,
         (url.find(".png") != string::npos || url.find(".jpg") != string::npos ||
          url.find(".jpeg") != string::npos || url.find(".PNG") != string::npos ||
          url.find(".JPG") != string::npos || url.find(".JPEG") != string::npos)) {
+        if (queryLog)
+            queryLog->append(QUERYLOG_IMAGE, url);
         return imageHandler(response, arguments, url);
     }
 
     //=============== SEARCH HANDLER ===============//
     string searchPage = "/search";
     if (url.substr(0, searchPage.size()) == searchPage) {
-        return searchHandler(response, arguments);
-    } else
+        logQuery(QUERYLOG_SEARCH, arguments);
+        return searchHandler(response, arguments, isClientGone);
+    } else {
+        if (queryLog)
+            queryLog->append(QUERYLOG_OTHER, url);
         return serve(url, response);
+    }
 
     return false;
 }
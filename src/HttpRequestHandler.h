@@ -12,33 +12,135 @@
 
 #include <sqlite3.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ConcurrentTrie.h"
+#include "Dawg.h"
 #include "HttpServer.h"
+#include "LoudsTrie.h"
+#include "Phrases.h"
+#include "QueryCompiler.h"
+#include "QueryLog.h"
+#include "SearchIndex.h"
+#include "SubstringIndex.h"
+#include "SymSpell.h"
 #include "trie.h"
 
+/**
+ * @brief Structure /predict completes words from
+ */
+// Rows found for one MATCH expression (HttpRequestHandler.cpp)
+struct SearchRows;
+
+enum AutocompleteMode {
+    AUTOCOMPLETE_TRIE,        // Trie built from the vocabulary database at startup
+    AUTOCOMPLETE_DAWG,        // Minimal automaton written by mkindex
+    AUTOCOMPLETE_LOUDS,       // Succinct read-only trie built at startup
+    AUTOCOMPLETE_CONCURRENT,  // Trie that keeps taking the words mkindex -watch appends
+};
+
 class HttpRequestHandler {
   public:
-    HttpRequestHandler(std::string homePath, bool imagemode = 0);
+    HttpRequestHandler(std::string homePath,
+                       bool imagemode = 0,
+                       AutocompleteMode autocompleteMode = AUTOCOMPLETE_TRIE,
+                       bool infixSuggestions = false);
     ~HttpRequestHandler();
 
-    bool handleRequest(std::string url, HttpArguments arguments, std::vector<char>& response);
+    bool handleRequest(std::string url,
+                       HttpArguments arguments,
+                       std::vector<char>& response,
+                       const ClientProbe& isClientGone = nullptr);
+    void setAdminEnabled(bool enabled);
+    void setQueryLog(QueryLog* queryLog);
+    // Searches the corrected text when a search finds nothing (see SymSpell.h)
+    void setAutocorrect(bool enabled);
+    // Time /search may spend in SQLite before listing unranked matches; 0: no limit
+    void setSearchTimeout(std::chrono::milliseconds timeout);
 
   private:
     bool serve(std::string path, std::vector<char>& response);
+    static bool normalizeRequestPath(const std::string& url, std::string& relativePath);
     bool loadVocabularyIntoTrie();
+    void loadBigrams(const IndexNames& names);
+    void loadPhrases(const IndexNames& names);
+    void followVocabulary();
+    void collectCompletions(const std::u32string& token,
+                            size_t maxSuggestions,
+                            std::vector<std::string>& completions);
+    std::chrono::steady_clock::time_point recordLoadTime(
+        const char* phase,
+        std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now());
 
     bool luckyHandler(std::vector<char>& response);
     bool predictHandler(std::vector<char>& response, HttpArguments& arguments);
     bool homePageHandler(std::vector<char>& response);
     bool imageHandler(std::vector<char>& response, HttpArguments& arguments, std::string& url);
-    bool searchHandler(std::vector<char>& response, HttpArguments& arguments);
+    std::shared_ptr<const SearchRows> coalesceSearch(
+        const std::string& key,
+        const std::function<std::shared_ptr<const SearchRows>()>& search);
+    bool searchHandler(std::vector<char>& response,
+                       HttpArguments& arguments,
+                       const ClientProbe& isClientGone);
+    bool adminHandler(std::vector<char>& response, std::string& url);
+    bool statsHandler(std::vector<char>& response);
+    bool correctSpelling(const std::string& query, std::string& correction) const;
+    void logQuery(QueryLogRoute route, HttpArguments& arguments);
 
     std::string homePath;
+    std::filesystem::path homeRootPath;
+    int homeRootFd;
     sqlite3* database;
+    // Turns the q argument of /search into a safe MATCH expression
+    QueryCompiler queryCompiler;
+    // "Did you mean" corrections for searches without results
+    SymSpell spelling;
+    bool autocorrect;
+    std::chrono::milliseconds searchTimeout;
+    // Searches running now, by exact and MATCH expression; identical ones arriving
+    // meanwhile wait for their rows (null: no rows, search again)
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<const SearchRows>>>
+        searchesInFlight;
+    std::mutex searchesLock;
+    size_t coalescedSearches;
     sqlite3* database_vocab;
     bool imagemode;
+    bool adminEnabled;
+    QueryLog* queryLog;
     const char* tableName;
     const char* vocabTableName;
+    AutocompleteMode autocompleteMode;
     Trie* trie;
+    ConcurrentTrie concurrentTrie;
+    // Polls the vocabulary for rows past vocabRowid (AUTOCOMPLETE_CONCURRENT)
+    sqlite3_int64 vocabRowid;
+    std::thread vocabularyFollower;
+    std::mutex followerLock;
+    std::condition_variable followerWake;
+    bool stopping;
+    Dawg dawg;
+    LoudsTrie loudsTrie;
+    bool infixSuggestions;
+    SubstringIndex substringIndex;
+    // Most frequent followers of each word, for /predict ranking
+    std::unordered_map<std::string, std::vector<std::string>> bigramFollowers;
+    // Frequent phrases mined by mkindex, completed across word boundaries
+    PhraseCompleter phraseCompleter;
+    // Startup phases and their duration in milliseconds, for /admin/stats
+    std::vector<std::pair<std::string, double>> loadTimes;
+    // sqlite3_db_status of the vocabulary connection just before it closed
+    std::string vocabDatabaseStatus;
 };
 
 #endif
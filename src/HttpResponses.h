@@ -77,14 +77,15 @@ namespace Responses {
                             const words = fullQuery.split(' ');\
                             const lastWord = words[words.length - 1].trim();\
                             \
-                            if (lastWord.length < 2) {\
+                            const nextWord = fullQuery.endsWith(' ') && fullQuery.trim().length > 0;\
+                            if (lastWord.length < 2 && !nextWord) {\
                                 suggestionsDiv.style.display = 'none';\
                                 return;\
                             }\
                             \
                             debounceTimer = setTimeout(async () => {\
                                 try {\
-                                    const response = await fetch('/predict?q=' + encodeURIComponent(lastWord));\
+                                    const response = await fetch('/predict?q=' + encodeURIComponent(fullQuery));\
                                     const suggestions = await response.json();\
                                     \
                                     if (suggestions.length > 0) {\
@@ -94,8 +95,7 @@ namespace Responses {
                                             div.className = 'suggestion-item';\
                                             div.textContent = suggestion;\
                                             div.onclick = () => {\
-                                                words[words.length - 1] = suggestion;\
-                                                input.value = words.join(' ') + ' ';\
+                                                input.value = suggestion + ' ';\
                                                 suggestionsDiv.style.display = 'none';\
                                                 input.focus();\
                                             };\
@@ -476,6 +476,23 @@ namespace Responses {
                     animation: fadeIn 0.5s ease;
                 }
 
+                .spelling {
+                    margin: -12px 0 24px;
+                    font-size: 16px;
+                }
+
+                .spelling a {
+                    color: var(--google-blue);
+                    font-weight: 600;
+                    font-style: italic;
+                }
+
+                .partial {
+                    margin: -12px 0 24px;
+                    font-size: 14px;
+                    color: #b06000;
+                }
+
                 @keyframes fadeIn {
                     from { opacity: 0; }
                     to { opacity: 1; }
@@ -573,7 +590,7 @@ namespace Responses {
 
                 .image-thumbnail img {
                     max-width: 300px; /* Larger width */
-                    height: 100%; /* Fill container height */
+                    height: auto; /* Aspect ratio from the width/height attributes */
                     object-fit: contain; /* Maintain aspect ratio without cropping */
                     display: block;
                 }
@@ -583,6 +600,12 @@ namespace Responses {
                     min-height: 150px; /* Approximate height for text block */
                 }
 
+                .image-meta {
+                    font-size: 13px;
+                    color: #70757a;
+                    margin-top: 4px;
+                }
+
                 @media (max-width: 768px) {
                     header {
                         flex-direction: column;
@@ -669,7 +692,8 @@ namespace Responses {
                     const words = fullQuery.split(' ');
                     const lastWord = words[words.length - 1].trim();
 
-                    if (lastWord.length < 2) {
+                    const nextWord = fullQuery.endsWith(' ') && fullQuery.trim().length > 0;
+                    if (lastWord.length < 2 && !nextWord) {
                         suggestionsDiv.classList.remove('show');
                         suggestionsOverlay.classList.remove('show');
                         return;
@@ -677,7 +701,7 @@ namespace Responses {
 
                     debounceTimer = setTimeout(async () => {
                         try {
-                            const response = await fetch('/predict?q=' + encodeURIComponent(lastWord));
+                            const response = await fetch('/predict?q=' + encodeURIComponent(fullQuery));
                             const suggestions = await response.json();
 
                             if (suggestions.length > 0) {
@@ -687,8 +711,7 @@ namespace Responses {
                                     div.className = 'suggestion-item';
                                     div.textContent = suggestion;
                                     div.onclick = () => {
-                                        words[words.length - 1] = suggestion;
-                                        input.value = words.join(' ') + ' ';
+                                        input.value = suggestion + ' ';
                                         suggestionsDiv.classList.remove('show');
                                         suggestionsOverlay.classList.remove('show');
                                         input.focus();
@@ -9,7 +9,12 @@
 
 #include "HttpServer.h"
 
+#ifdef __linux__
+#include <poll.h>
+#endif
+
 #include "HttpRequestHandler.h"
+#include "Trace.h"
 
 using namespace std;
 
@@ -37,6 +42,32 @@ static MHD_Result httpGetArgumentCallback(void* cls,
     return MHD_YES;
 }
 
+/**
+ * @brief Checks whether the client has hung up while its request is handled
+ *
+ * libmicrohttpd only notices when it next polls the socket, after the
+ * handler returns, so the socket is polled directly. Only a reset or error
+ * counts: a FIN (POLLRDHUP) may be a legal half-close by a client still
+ * reading the response, and cannot be told apart from a full close, so
+ * those requests run until they finish or reach their deadline.
+ *
+ * @param connection The connection
+ * @return True if the peer reset the connection
+ */
+static bool isConnectionClosed(struct MHD_Connection* connection) {
+#ifdef __linux__
+    const MHD_ConnectionInfo* info =
+        MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CONNECTION_FD);
+    if (!info)
+        return false;
+
+    pollfd descriptor = {info->connect_fd, 0, 0};
+    return poll(&descriptor, 1, 0) > 0 && (descriptor.revents & (POLLHUP | POLLERR | POLLNVAL));
+#else
+    return false;
+#endif
+}
+
 /**
  * @brief HTTP request handler for libmicrohttpd
  *
@@ -69,10 +100,15 @@ MHD_Result httpRequestHandlerCallback(void* cls,
 
     // We only handle get requests
     if ((string(method) == "GET")) {
+        Trace::Request traceRequest("HttpServer::request");
+
         // Get arguments
         HttpArguments arguments;
-        MHD_get_connection_values(
-            connection, MHD_GET_ARGUMENT_KIND, httpGetArgumentCallback, &arguments);
+        {
+            TRACE_SPAN("HttpServer::arguments");
+            MHD_get_connection_values(
+                connection, MHD_GET_ARGUMENT_KIND, httpGetArgumentCallback, &arguments);
+        }
 
         // Make response
         int statusCode;
@@ -88,7 +124,10 @@ MHD_Result httpRequestHandlerCallback(void* cls,
             cleanedUrl += "index.html";
 
         if (server->httpRequestHandler &&
-            server->httpRequestHandler->handleRequest(cleanedUrl, arguments, response))
+            server->httpRequestHandler->handleRequest(
+                cleanedUrl, arguments, response, [connection]() {
+                    return isConnectionClosed(connection);
+                }))
             statusCode = MHD_HTTP_FOUND;
         else {
             statusCode = MHD_HTTP_NOT_FOUND;
@@ -97,6 +136,7 @@ MHD_Result httpRequestHandlerCallback(void* cls,
             response.assign(errorResponse.begin(), errorResponse.end());
         }
 
+        TRACE_SPAN("HttpServer::queueResponse");
         MHD_Response* mhdResponse = MHD_create_response_from_buffer(
             response.size(), (void*)response.data(), MHD_RESPMEM_MUST_COPY);
         bool isResponseQueued = MHD_queue_response(connection, statusCode, mhdResponse);
@@ -108,15 +148,28 @@ MHD_Result httpRequestHandlerCallback(void* cls,
     return MHD_NO;
 }
 
-HttpServer::HttpServer(int port) {
+HttpServer::HttpServer(int port, unsigned threadCount) {
     // CRITICAL FIX: Use the 'port' parameter instead of hardcoded 8000
-    daemon = MHD_start_daemon(MHD_USE_INTERNAL_POLLING_THREAD,
-                              port,
-                              NULL,
-                              NULL,
-                              httpRequestHandlerCallback,
-                              this,
-                              MHD_OPTION_END);
+    if (threadCount > 1) {
+        // Each pool thread polls its own share of the connections
+        daemon = MHD_start_daemon(MHD_USE_INTERNAL_POLLING_THREAD,
+                                  port,
+                                  NULL,
+                                  NULL,
+                                  httpRequestHandlerCallback,
+                                  this,
+                                  MHD_OPTION_THREAD_POOL_SIZE,
+                                  threadCount,
+                                  MHD_OPTION_END);
+    } else {
+        daemon = MHD_start_daemon(MHD_USE_INTERNAL_POLLING_THREAD,
+                                  port,
+                                  NULL,
+                                  NULL,
+                                  httpRequestHandlerCallback,
+                                  this,
+                                  MHD_OPTION_END);
+    }
 
     httpRequestHandler = NULL;
 }
@@ -12,17 +12,24 @@
 
 #include <microhttpd.h>
 
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
 
 typedef std::map<std::string, std::string> HttpArguments;
+// True once the client of the request being handled has closed its connection
+typedef std::function<bool()> ClientProbe;
 
 class HttpRequestHandler;
 
 class HttpServer {
   public:
-    HttpServer(int port);
+    /**
+     * @param port TCP port
+     * @param threadCount Request threads; 1 keeps the single polling thread
+     */
+    HttpServer(int port, unsigned threadCount = 1);
     ~HttpServer();
 
     bool isRunning();
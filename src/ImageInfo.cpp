@@ -0,0 +1,96 @@
+/**
+ * @file ImageInfo.cpp
+ * @brief PNG/JPEG header parsing (dimensions without decoding)
+ * @version 1.0
+ */
+
+#include "ImageInfo.h"
+
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+static uint32_t readBigEndian(const unsigned char* data, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+static bool readPngInfo(ifstream& file, ImageInfo& info) {
+    // Signature (8), chunk length (4), "IHDR" (4), width (4), height (4)
+    unsigned char header[24];
+    file.seekg(0);
+    if (!file.read((char*)header, sizeof(header)) || memcmp(header + 12, "IHDR", 4) != 0)
+        return false;
+
+    info.width = readBigEndian(header + 16, 4);
+    info.height = readBigEndian(header + 20, 4);
+    info.format = "png";
+    return true;
+}
+
+static bool readJpegInfo(ifstream& file, ImageInfo& info) {
+    // Walks marker segments after SOI until a start-of-frame
+    streamoff position = 2;
+
+    while (position + 4 <= (streamoff)info.bytes) {
+        unsigned char segment[9];
+        file.seekg(position);
+        if (!file.read((char*)segment, 4) || segment[0] != 0xFF)
+            return false;
+
+        unsigned char marker = segment[1];
+        uint32_t length = readBigEndian(segment + 2, 2);
+
+        // Fill bytes and standalone markers carry no length
+        if (marker == 0xFF) {
+            position += 1;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            position += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA || length < 2)
+            return false;
+
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+            marker != 0xCC) {
+            if (!file.read((char*)segment + 4, 5))
+                return false;
+
+            info.height = readBigEndian(segment + 5, 2);
+            info.width = readBigEndian(segment + 7, 2);
+            info.format = "jpeg";
+            return true;
+        }
+
+        position += 2 + length;
+    }
+
+    return false;
+}
+
+bool readImageInfo(const string& path, ImageInfo& info) {
+    ifstream file(path, ios::binary);
+    if (file.fail())
+        return false;
+
+    file.seekg(0, ios::end);
+    info.bytes = file.tellg();
+    file.seekg(0, ios::beg);
+
+    unsigned char magic[8];
+    if (!file.read((char*)magic, sizeof(magic)))
+        return false;
+
+    if (memcmp(magic, "\x89PNG\r\n\x1a\n", 8) == 0)
+        return readPngInfo(file, info);
+    if (magic[0] == 0xFF && magic[1] == 0xD8)
+        return readJpegInfo(file, info);
+
+    return false;
+}
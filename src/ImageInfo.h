@@ -0,0 +1,36 @@
+/**
+ * @file ImageInfo.h
+ * @brief PNG/JPEG header parsing (dimensions without decoding)
+ * @version 1.0
+ */
+
+#ifndef IMAGEINFO_H
+#define IMAGEINFO_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Image metadata stored in the image index
+ */
+struct ImageInfo {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t bytes = 0;
+    std::string format;  // "png", "jpeg" or empty if unknown
+};
+
+/**
+ * @name readImageInfo
+ * @brief Reads dimensions from the PNG IHDR chunk or the JPEG SOF marker
+ *
+ * Only headers are read: PNG needs its first 24 bytes, JPEG segments are
+ * skipped by their length fields until a start-of-frame marker appears.
+ *
+ * @param path Image file
+ * @param info Output metadata (bytes is always filled if the file exists)
+ * @return True if the format and dimensions were recognized
+ */
+bool readImageInfo(const std::string& path, ImageInfo& info);
+
+#endif
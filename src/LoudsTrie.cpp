@@ -0,0 +1,304 @@
+/**
+ * @file LoudsTrie.cpp
+ * @brief Succinct read-only trie (LOUDS) over the vocabulary
+ * @version 1.0
+ */
+
+#include "LoudsTrie.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+
+using namespace std;
+
+static const uint32_t NO_NODE = 0xFFFFFFFFU;
+static const size_t WORDS_PER_BLOCK = 8;
+static const size_t BLOCK_BITS = 64 * WORDS_PER_BLOCK;
+static const size_t ZERO_SAMPLE_RATE = 512;
+
+static inline unsigned popcount64(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (unsigned)__popcnt64(value);
+#elif defined(__POPCNT__)
+    return (unsigned)__builtin_popcountll(value);
+#else
+    // Without the POPCNT instruction the builtin is a library call
+    value = value - ((value >> 1) & 0x5555555555555555ULL);
+    value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned)((value * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline unsigned lowestSetBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctzll(value);
+#endif
+}
+
+//============================= BIT VECTOR =============================//
+
+void RankSelectBitVector::pushBack(bool bit) {
+    if (bitCount % 64 == 0)
+        words.push_back(0);
+    if (bit)
+        words.back() |= 1ULL << (bitCount % 64);
+    bitCount++;
+}
+
+void RankSelectBitVector::finish() {
+    size_t blockCount = (words.size() + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK;
+    blockRanks.assign(blockCount + 1, 0);
+    subRanks.assign(blockCount, 0);
+    zeroSamples.clear();
+
+    size_t ones = 0;
+    size_t zeros = 0;
+    for (size_t block = 0; block < blockCount; block++) {
+        blockRanks[block] = (uint32_t)ones;
+
+        // Ones before words 1..7 of the block, 9 bits each
+        size_t blockEnd = min(words.size(), (block + 1) * WORDS_PER_BLOCK);
+        size_t blockOnes = 0;
+        for (size_t i = block * WORDS_PER_BLOCK; i < blockEnd; i++) {
+            size_t word = i - block * WORDS_PER_BLOCK;
+            if (word)
+                subRanks[block] |= (uint64_t)blockOnes << (9 * (word - 1));
+            blockOnes += popcount64(words[i]);
+        }
+
+        // Padding past bitCount is not counted as zeros
+        size_t blockBits = min(bitCount, (block + 1) * BLOCK_BITS) - block * BLOCK_BITS;
+        size_t blockZeros = blockBits - blockOnes;
+        while (zeroSamples.size() * ZERO_SAMPLE_RATE < zeros + blockZeros)
+            zeroSamples.push_back((uint32_t)block);
+
+        ones += blockOnes;
+        zeros += blockZeros;
+    }
+    blockRanks[blockCount] = (uint32_t)ones;
+}
+
+size_t RankSelectBitVector::subRank(size_t block, size_t word) const {
+    return word ? (subRanks[block] >> (9 * (word - 1))) & 0x1FF : 0;
+}
+
+bool RankSelectBitVector::get(size_t position) const {
+    return (words[position / 64] >> (position % 64)) & 1;
+}
+
+size_t RankSelectBitVector::rank1(size_t position) const {
+    size_t block = position / BLOCK_BITS;
+    if (block == subRanks.size())
+        return blockRanks[block];
+
+    // At the end of a word-aligned vector no sub-rank covers the next word
+    size_t word = position / 64;
+    if (word == words.size())
+        return blockRanks[block + 1];
+
+    size_t rank = blockRanks[block] + subRank(block, word % WORDS_PER_BLOCK);
+    if (position % 64)
+        rank += popcount64(words[word] & ((1ULL << (position % 64)) - 1));
+    return rank;
+}
+
+size_t RankSelectBitVector::select0(size_t k) const {
+    // Last block whose zeros-before count is <= k, between two samples
+    size_t sample = k / ZERO_SAMPLE_RATE;
+    size_t low = zeroSamples[sample];
+    size_t high = sample + 1 < zeroSamples.size() ? zeroSamples[sample + 1] : subRanks.size() - 1;
+    while (low < high) {
+        size_t middle = (low + high + 1) / 2;
+        if (middle * BLOCK_BITS - blockRanks[middle] <= k)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    // Last word of the block whose zeros-before count is <= k
+    size_t remaining = k - (low * BLOCK_BITS - blockRanks[low]);
+    size_t lastWord = min(WORDS_PER_BLOCK, words.size() - low * WORDS_PER_BLOCK);
+    size_t word = 0;
+    while (word + 1 < lastWord && (word + 1) * 64 - subRank(low, word + 1) <= remaining)
+        word++;
+    remaining -= word * 64 - subRank(low, word);
+
+    uint64_t zeroBits = ~words[low * WORDS_PER_BLOCK + word];
+    for (; remaining; remaining--)
+        zeroBits &= zeroBits - 1;
+    return (low * WORDS_PER_BLOCK + word) * 64 + lowestSetBit(zeroBits);
+}
+
+size_t RankSelectBitVector::size() const {
+    return bitCount;
+}
+
+size_t RankSelectBitVector::getMemoryUsage() const {
+    return words.size() * sizeof(uint64_t) + blockRanks.size() * sizeof(uint32_t) +
+           subRanks.size() * sizeof(uint64_t) + zeroSamples.size() * sizeof(uint32_t);
+}
+
+//================================ TRIE ================================//
+
+bool LoudsTrie::build(const vector<string>& sortedWords) {
+    for (size_t i = 1; i < sortedWords.size(); i++) {
+        if (!(sortedWords[i - 1] < sortedWords[i]))
+            return false;
+    }
+
+    shape = RankSelectBitVector();
+    finals = RankSelectBitVector();
+    labels.clear();
+
+    // Level order: each node is the range of words sharing its prefix
+    struct Range {
+        uint32_t begin, end, depth;
+    };
+    vector<Range> queue = {{0, (uint32_t)sortedWords.size(), 0}};
+    for (size_t head = 0; head < queue.size(); head++) {
+        Range node = queue[head];
+        uint32_t i = node.begin;
+
+        // Sorted order puts the word equal to the prefix first
+        bool isFinal = i < node.end && sortedWords[i].size() == node.depth;
+        finals.pushBack(isFinal);
+        if (isFinal)
+            i++;
+
+        while (i < node.end) {
+            uint8_t label = (uint8_t)sortedWords[i][node.depth];
+            uint32_t groupEnd = i + 1;
+            while (groupEnd < node.end && (uint8_t)sortedWords[groupEnd][node.depth] == label)
+                groupEnd++;
+
+            shape.pushBack(true);
+            labels.push_back(label);
+            queue.push_back({i, groupEnd, node.depth + 1});
+            i = groupEnd;
+        }
+        shape.pushBack(false);
+    }
+
+    shape.finish();
+    finals.finish();
+    labels.shrink_to_fit();
+    wordCount = finals.rank1(finals.size());
+    return true;
+}
+
+void LoudsTrie::childRange(uint32_t node, uint32_t& begin, uint32_t& end) const {
+    // Bits before node's degree run hold node zeros; the rest are edges
+    size_t start = node ? shape.select0(node - 1) + 1 : 0;
+    begin = (uint32_t)(start - node);
+    end = (uint32_t)(shape.select0(node) - node);
+}
+
+uint32_t LoudsTrie::child(uint32_t node, uint8_t label) const {
+    uint32_t begin, end;
+    childRange(node, begin, end);
+    auto edge = lower_bound(labels.begin() + begin, labels.begin() + end, label);
+    if (edge == labels.begin() + end || *edge != label)
+        return NO_NODE;
+    return (uint32_t)(edge - labels.begin()) + 1;
+}
+
+uint32_t LoudsTrie::walk(const string& prefix) const {
+    if (!wordCount)
+        return NO_NODE;
+
+    uint32_t node = 0;
+    for (char c : prefix) {
+        node = child(node, (uint8_t)c);
+        if (node == NO_NODE)
+            break;
+    }
+    return node;
+}
+
+bool LoudsTrie::startsWith(const string& prefix) const {
+    return walk(prefix) != NO_NODE;
+}
+
+bool LoudsTrie::contains(const string& word) const {
+    uint32_t node = walk(word);
+    return node != NO_NODE && finals.get(node);
+}
+
+size_t LoudsTrie::collectSuggestions(const string& prefix,
+                                     size_t maxSuggestions,
+                                     vector<string>& suggestions) const {
+    uint32_t node = walk(prefix);
+    if (node == NO_NODE || maxSuggestions == 0)
+        return 0;
+
+    // Depth-first, in label order; each frame holds its next and last edge.
+    // Siblings' child ranges are adjacent, so each child needs one select
+    // once its left sibling was expanded
+    struct Frame {
+        uint32_t edge, end, childBegin;
+    };
+    size_t collected = 0;
+    string word = prefix;
+    vector<Frame> stack;
+
+    if (finals.get(node)) {
+        suggestions.push_back(word);
+        collected++;
+    }
+    Frame root;
+    childRange(node, root.edge, root.end);
+    root.childBegin = NO_NODE;
+    stack.push_back(root);
+
+    while (!stack.empty() && collected < maxSuggestions) {
+        Frame& frame = stack.back();
+        if (frame.edge == frame.end) {
+            stack.pop_back();
+            if (!stack.empty())
+                word.pop_back();
+            continue;
+        }
+
+        uint32_t edge = frame.edge++;
+        uint32_t next = edge + 1;
+        word.push_back((char)labels[edge]);
+
+        if (finals.get(next)) {
+            suggestions.push_back(word);
+            collected++;
+        }
+
+        Frame nextFrame;
+        if (frame.childBegin == NO_NODE) {
+            childRange(next, nextFrame.edge, nextFrame.end);
+        } else {
+            nextFrame.edge = frame.childBegin;
+            nextFrame.end = (uint32_t)(shape.select0(next) - next);
+        }
+        nextFrame.childBegin = NO_NODE;
+        frame.childBegin = nextFrame.end;
+        stack.push_back(nextFrame);
+    }
+
+    return collected;
+}
+
+size_t LoudsTrie::getWordCount() const {
+    return wordCount;
+}
+
+size_t LoudsTrie::getNodeCount() const {
+    return finals.size();
+}
+
+size_t LoudsTrie::getMemoryUsage() const {
+    return shape.getMemoryUsage() + finals.getMemoryUsage() + labels.size();
+}
@@ -0,0 +1,123 @@
+/**
+ * @file LoudsTrie.h
+ * @brief Succinct read-only trie (LOUDS) over the vocabulary
+ * @version 1.0
+ *
+ * Nodes are numbered in level order and the shape is stored as a
+ * level-order unary degree sequence: every node writes one 1 bit per child
+ * followed by a 0. With a select directory over those bits, the children of
+ * a node are found without pointers, so the trie costs about two bits per
+ * node plus one label byte and one final bit. Edges are labeled with UTF-8
+ * bytes, like the DAWG, so enumeration is lexicographic.
+ */
+
+#ifndef LOUDSTRIE_H
+#define LOUDSTRIE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class RankSelectBitVector
+ * @brief Bit vector with constant-time rank and logarithmic select over zeros
+ *
+ * Rank9 layout: an absolute count per 512-bit block plus seven 9-bit
+ * counts packed in one word, so neither query popcounts a whole block.
+ */
+class RankSelectBitVector {
+  public:
+    void pushBack(bool bit);
+
+    /**
+     * @name finish
+     * @brief Builds the rank and select directories; call once after the last bit
+     */
+    void finish();
+
+    bool get(size_t position) const;
+
+    /**
+     * @name rank1
+     * @brief Number of 1 bits before position
+     */
+    size_t rank1(size_t position) const;
+
+    /**
+     * @name select0
+     * @brief Position of the k-th 0 bit (0-based)
+     */
+    size_t select0(size_t k) const;
+
+    size_t size() const;
+    size_t getMemoryUsage() const;
+
+  private:
+    size_t subRank(size_t block, size_t word) const;
+
+    std::vector<uint64_t> words;
+    size_t bitCount = 0;
+    // Ones before each 512-bit block
+    std::vector<uint32_t> blockRanks;
+    // Ones before each word within its block
+    std::vector<uint64_t> subRanks;
+    // Block holding every 512th zero, narrows the select search
+    std::vector<uint32_t> zeroSamples;
+};
+
+/**
+ * @class LoudsTrie
+ * @brief Read-only trie built once from the sorted vocabulary
+ */
+class LoudsTrie {
+  public:
+    /**
+     * @name build
+     * @brief Builds the trie from sorted, unique UTF-8 words
+     * @param sortedWords Words in ascending byte order
+     * @return False if the words are not sorted and unique
+     */
+    bool build(const std::vector<std::string>& sortedWords);
+
+    /**
+     * @name startsWith
+     * @brief Checks if any word starts with the given prefix
+     */
+    bool startsWith(const std::string& prefix) const;
+
+    /**
+     * @name contains
+     * @brief Checks whether a whole word is in the trie
+     */
+    bool contains(const std::string& word) const;
+
+    /**
+     * @name collectSuggestions
+     * @brief Appends up to maxSuggestions words starting with prefix, in order
+     * @param prefix UTF-8 prefix
+     * @param maxSuggestions Maximum number of words
+     * @param suggestions Output words
+     * @return Number of words appended
+     */
+    size_t collectSuggestions(const std::string& prefix,
+                              size_t maxSuggestions,
+                              std::vector<std::string>& suggestions) const;
+
+    size_t getWordCount() const;
+    size_t getNodeCount() const;
+    size_t getMemoryUsage() const;
+
+  private:
+    uint32_t walk(const std::string& prefix) const;
+    uint32_t child(uint32_t node, uint8_t label) const;
+    void childRange(uint32_t node, uint32_t& begin, uint32_t& end) const;
+
+    // Node v has children v + 1 + edge for edge in childRange(v)
+    RankSelectBitVector shape;
+    RankSelectBitVector finals;
+    // Label of the edge into node e + 1
+    std::vector<uint8_t> labels;
+    size_t wordCount = 0;
+};
+
+#endif
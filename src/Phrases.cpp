@@ -0,0 +1,272 @@
+/**
+ * @file Phrases.cpp
+ * @brief Frequent 2-3 word phrases: mined by mkindex, completed by edahttpd
+ * @version 1.0
+ */
+
+#include "Phrases.h"
+
+#include "TextProcessing.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+using namespace std;
+
+// Words kept inside a phrase, so "arbol de busqueda" is one phrase
+static const size_t MIN_PHRASE_WORD_LENGTH = 1;
+// Words a phrase may start or end with, which drops "de la" and "la casa"
+static const size_t MIN_PHRASE_EDGE_LENGTH = 3;
+static const size_t MAX_PHRASE_WORDS = 3;
+
+//=============================== MINER ================================//
+
+/**
+ * @brief Finalizer of splitmix64, spreads a hash over all 64 bits
+ */
+static uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+PhraseMiner::PhraseMiner(size_t capacity, size_t sketchWidth, size_t sketchDepth)
+    : capacity(capacity), sketchDepth(max<size_t>(sketchDepth, 1)) {
+    size_t width = 1;
+    while (width < sketchWidth)
+        width <<= 1;
+    sketchMask = width - 1;
+    sketch.assign(width * this->sketchDepth, 0);
+    heap.reserve(capacity);
+    heapIndex.reserve(capacity);
+}
+
+void PhraseMiner::addText(const string& text) {
+    // Sliding window over the last MAX_PHRASE_WORDS words and their lengths
+    vector<pair<string, size_t>> window;
+    string phrase;
+    forEachWord(
+        converter.from_bytes(text),
+        [&](const u32string& word) {
+            if (window.size() == MAX_PHRASE_WORDS)
+                window.erase(window.begin());
+            window.emplace_back(converter.to_bytes(word), word.size());
+            if (word.size() < MIN_PHRASE_EDGE_LENGTH)
+                return;
+
+            // Every phrase ending with this word, two words and longer
+            for (size_t words = 2; words <= window.size(); words++) {
+                size_t start = window.size() - words;
+                if (window[start].second < MIN_PHRASE_EDGE_LENGTH)
+                    continue;
+
+                phrase = window[start].first;
+                for (size_t i = start + 1; i < window.size(); i++) {
+                    phrase += ' ';
+                    phrase += window[i].first;
+                }
+                add(phrase);
+            }
+        },
+        MIN_PHRASE_WORD_LENGTH);
+}
+
+uint32_t PhraseMiner::increment(const string& phrase) {
+    // Row hashes derived from two base hashes (Kirsch-Mitzenmacher)
+    uint64_t first = mix(hash<string>()(phrase));
+    uint64_t second = mix(first) | 1;
+    size_t width = sketchMask + 1;
+    auto counter = [&](size_t row) -> uint32_t& {
+        return sketch[row * width + ((size_t)(first + row * second) & sketchMask)];
+    };
+
+    // Conservative update: only the smallest counters grow, which keeps
+    // the overestimate of rare phrases colliding with frequent ones low
+    uint32_t estimate = UINT32_MAX;
+    for (size_t row = 0; row < sketchDepth; row++)
+        estimate = min(estimate, counter(row));
+    if (estimate == UINT32_MAX)
+        return estimate;
+
+    estimate++;
+    for (size_t row = 0; row < sketchDepth; row++)
+        counter(row) = max(counter(row), estimate);
+    return estimate;
+}
+
+void PhraseMiner::add(const string& phrase) {
+    uint32_t estimate = increment(phrase);
+
+    auto tracked = heapIndex.find(phrase);
+    if (tracked != heapIndex.end()) {
+        // Counts only grow, so a tracked phrase can only move down the min-heap
+        heap[tracked->second].count = estimate;
+        siftDown(tracked->second);
+    } else if (heap.size() < capacity) {
+        heapIndex.emplace(phrase, heap.size());
+        heap.push_back({estimate, phrase});
+        siftUp(heap.size() - 1);
+    } else if (capacity && estimate > heap[0].count) {
+        // Replaces the lightest tracked phrase
+        heapIndex.erase(heap[0].phrase);
+        heap[0] = {estimate, phrase};
+        heapIndex.emplace(phrase, 0);
+        siftDown(0);
+    }
+}
+
+void PhraseMiner::swapEntries(size_t a, size_t b) {
+    swap(heap[a], heap[b]);
+    heapIndex[heap[a].phrase] = a;
+    heapIndex[heap[b].phrase] = b;
+}
+
+void PhraseMiner::siftUp(size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap[parent].count <= heap[index].count)
+            break;
+        swapEntries(parent, index);
+        index = parent;
+    }
+}
+
+void PhraseMiner::siftDown(size_t index) {
+    while (true) {
+        size_t smallest = index;
+        for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap.size(); child++) {
+            if (heap[child].count < heap[smallest].count)
+                smallest = child;
+        }
+        if (smallest == index)
+            break;
+        swapEntries(index, smallest);
+        index = smallest;
+    }
+}
+
+vector<pair<string, uint32_t>> PhraseMiner::getPhrases(uint32_t minCount) const {
+    vector<pair<string, uint32_t>> phrases;
+    for (const Entry& entry : heap) {
+        if (entry.count >= minCount)
+            phrases.emplace_back(entry.phrase, entry.count);
+    }
+    sort(phrases.begin(), phrases.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return phrases;
+}
+
+size_t PhraseMiner::getMemoryUsage() const {
+    size_t bytes = sketch.capacity() * sizeof(uint32_t) + heap.capacity() * sizeof(Entry);
+    for (const Entry& entry : heap)
+        bytes += 2 * entry.phrase.capacity();
+    return bytes;
+}
+
+//============================== COMPLETER ==============================//
+
+void PhraseCompleter::build(vector<pair<string, uint32_t>> weightedPhrases) {
+    sort(weightedPhrases.begin(), weightedPhrases.end());
+    weightedPhrases.erase(unique(weightedPhrases.begin(),
+                                 weightedPhrases.end(),
+                                 [](const auto& a, const auto& b) { return a.first == b.first; }),
+                          weightedPhrases.end());
+
+    phrases.clear();
+    weights.clear();
+    phrases.reserve(weightedPhrases.size());
+    weights.reserve(weightedPhrases.size());
+    for (auto& phrase : weightedPhrases) {
+        phrases.push_back(move(phrase.first));
+        weights.push_back(phrase.second);
+    }
+
+    // Level k answers ranges of length 2^k from two overlapping halves
+    sparseTable.clear();
+    size_t n = phrases.size();
+    if (!n)
+        return;
+    sparseTable.emplace_back(n);
+    for (uint32_t i = 0; i < n; i++)
+        sparseTable[0][i] = i;
+    for (size_t length = 2; length <= n; length <<= 1) {
+        const vector<uint32_t>& previous = sparseTable.back();
+        vector<uint32_t> level(n - length + 1);
+        for (size_t i = 0; i < level.size(); i++) {
+            uint32_t left = previous[i];
+            uint32_t right = previous[i + length / 2];
+            level[i] = weights[right] > weights[left] ? right : left;
+        }
+        sparseTable.push_back(move(level));
+    }
+}
+
+uint32_t PhraseCompleter::heaviest(uint32_t begin, uint32_t end) const {
+    size_t level = 0;
+    while ((size_t)2 << level <= end - begin)
+        level++;
+    uint32_t left = sparseTable[level][begin];
+    uint32_t right = sparseTable[level][end - ((size_t)1 << level)];
+    return weights[right] > weights[left] ? right : left;
+}
+
+size_t PhraseCompleter::collectSuggestions(const string& prefix,
+                                           size_t maxSuggestions,
+                                           vector<string>& suggestions) const {
+    if (prefix.empty() || maxSuggestions == 0 || phrases.empty())
+        return 0;
+
+    // Phrases starting with prefix are contiguous in sorted order
+    auto first = lower_bound(phrases.begin(), phrases.end(), prefix);
+    auto last = partition_point(first, phrases.end(), [&](const string& phrase) {
+        return phrase.compare(0, prefix.size(), prefix) == 0;
+    });
+    if (first == last)
+        return 0;
+
+    // Best-first over subranges: each pop yields the next heaviest phrase
+    // and splits its range in two, so k results cost O(k log k)
+    typedef tuple<uint32_t, uint32_t, uint32_t, uint32_t> Range;  // weight, best, begin, end
+    priority_queue<Range> ranges;
+    auto pushRange = [&](uint32_t begin, uint32_t end) {
+        if (begin < end) {
+            uint32_t best = heaviest(begin, end);
+            // Ties go to the earlier phrase (larger negated index)
+            ranges.emplace(weights[best], UINT32_MAX - best, begin, end);
+        }
+    };
+    pushRange((uint32_t)(first - phrases.begin()), (uint32_t)(last - phrases.begin()));
+
+    size_t added = 0;
+    while (!ranges.empty() && added < maxSuggestions) {
+        uint32_t begin, end, best;
+        tie(ignore, best, begin, end) = ranges.top();
+        ranges.pop();
+        best = UINT32_MAX - best;
+
+        suggestions.push_back(phrases[best]);
+        added++;
+        pushRange(begin, best);
+        pushRange(best + 1, end);
+    }
+    return added;
+}
+
+size_t PhraseCompleter::size() const {
+    return phrases.size();
+}
+
+size_t PhraseCompleter::getMemoryUsage() const {
+    size_t bytes = phrases.capacity() * sizeof(string) + weights.capacity() * sizeof(uint32_t);
+    for (const string& phrase : phrases)
+        bytes += phrase.capacity();
+    for (const vector<uint32_t>& level : sparseTable)
+        bytes += level.capacity() * sizeof(uint32_t);
+    return bytes;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file Phrases.h
+ * @brief Frequent 2-3 word phrases: mined by mkindex, completed by edahttpd
+ * @version 1.0
+ *
+ * Counting every n-gram of a corpus exactly takes memory proportional to
+ * the corpus. PhraseMiner instead keeps a Count-Min sketch (fixed size,
+ * overestimates only) and tracks the most frequent phrases in a bounded
+ * min-heap. PhraseCompleter returns the heaviest phrases under a prefix
+ * with a range-maximum table, without scanning the prefix range.
+ */
+
+#ifndef PHRASES_H
+#define PHRASES_H
+
+#include <codecvt>
+#include <cstdint>
+#include <locale>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PhraseMiner
+ * @brief Streams text and keeps the heaviest 2-3 word phrases
+ */
+class PhraseMiner {
+  public:
+    /**
+     * @param capacity Phrases tracked by the heavy-hitters heap
+     * @param sketchWidth Counters per sketch row (rounded up to a power of two)
+     * @param sketchDepth Sketch rows
+     */
+    PhraseMiner(size_t capacity = 20000, size_t sketchWidth = 1 << 20, size_t sketchDepth = 4);
+
+    /**
+     * @name addText
+     * @brief Counts every 2 and 3 word phrase of a text
+     *
+     * Words are tokenized as in forEachWord, keeping short ones, so phrases
+     * such as "arbol de busqueda" survive. Phrases must start and end with
+     * a word of 3+ letters.
+     *
+     * @param text Plain text (UTF-8)
+     */
+    void addText(const std::string& text);
+
+    /**
+     * @name add
+     * @brief Counts one occurrence of a phrase
+     */
+    void add(const std::string& phrase);
+
+    /**
+     * @name getPhrases
+     * @brief Tracked phrases seen at least minCount times, heaviest first
+     */
+    std::vector<std::pair<std::string, uint32_t>> getPhrases(uint32_t minCount = 2) const;
+
+    size_t getMemoryUsage() const;
+
+  private:
+    uint32_t increment(const std::string& phrase);
+    void siftDown(size_t index);
+    void siftUp(size_t index);
+    void swapEntries(size_t a, size_t b);
+
+    struct Entry {
+        uint32_t count;
+        std::string phrase;
+    };
+
+    size_t capacity;
+    size_t sketchMask;
+    size_t sketchDepth;
+    std::vector<uint32_t> sketch;
+    // Min-heap on count; heapIndex finds a tracked phrase's entry
+    std::vector<Entry> heap;
+    std::unordered_map<std::string, size_t> heapIndex;
+    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
+};
+
+/**
+ * @class PhraseCompleter
+ * @brief Weighted prefix completion over a fixed set of phrases
+ */
+class PhraseCompleter {
+  public:
+    /**
+     * @name build
+     * @brief Sorts the phrases and builds the range-maximum table
+     * @param phrases Phrases and weights, in any order
+     */
+    void build(std::vector<std::pair<std::string, uint32_t>> phrases);
+
+    /**
+     * @name collectSuggestions
+     * @brief Appends the maxSuggestions heaviest phrases starting with prefix
+     * @param prefix Lowercase UTF-8 prefix
+     * @param maxSuggestions Maximum number of phrases
+     * @param suggestions Output phrases, heaviest first
+     * @return Number of phrases appended
+     */
+    size_t collectSuggestions(const std::string& prefix,
+                              size_t maxSuggestions,
+                              std::vector<std::string>& suggestions) const;
+
+    size_t size() const;
+    size_t getMemoryUsage() const;
+
+  private:
+    uint32_t heaviest(uint32_t begin, uint32_t end) const;
+
+    std::vector<std::string> phrases;
+    std::vector<uint32_t> weights;
+    // sparseTable[k][i]: heaviest index in [i, i + 2^k)
+    std::vector<std::vector<uint32_t>> sparseTable;
+};
+
+#endif
@@ -0,0 +1,322 @@
+/**
+ * @file QueryCompiler.cpp
+ * @brief Compiles user search text into a well-formed FTS5 MATCH expression
+ * @version 1.0
+ */
+
+#include "QueryCompiler.h"
+
+#include <unicode/normalizer2.h>
+#include <unicode/uchar.h>
+#include <unicode/unistr.h>
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+
+using namespace std;
+
+// Terms kept from one query; the most frequent ones are dropped beyond it
+static const size_t MAX_QUERY_TERMS = 16;
+// Vocabulary words a trailing prefix may expand to ("a*" would scan them all)
+static const size_t MAX_PREFIX_EXPANSION = 256;
+
+// Documents of the rarest term that multi-term counts are sampled over
+static const int64_t HIT_SAMPLE = 512;
+
+// Spanish and English function words, folded; they match nearly every document
+static const unordered_set<string> STOPWORDS = {
+    "a",     "al",     "algo",   "ante",    "antes",  "como",  "con",    "contra", "cual",
+    "cuando", "de",    "del",    "desde",   "donde",  "durante", "e",    "el",     "ella",
+    "ellos", "en",     "entre",  "era",     "es",     "esa",   "ese",    "eso",    "esta",
+    "estan", "estas",  "este",   "esto",    "estos",  "fue",   "ha",     "han",    "hasta",
+    "hay",   "la",     "las",    "le",      "les",    "lo",    "los",    "mas",    "me",
+    "mi",    "muy",    "ni",     "nos",     "o",      "otra",  "otro",   "para",   "pero",
+    "por",   "porque", "que",    "quien",   "se",     "ser",   "si",     "sin",    "sobre",
+    "son",   "su",     "sus",    "tambien", "te",     "todo",  "tu",     "u",      "un",
+    "una",   "uno",    "unos",   "y",       "ya",     "yo",    "an",     "and",    "are",
+    "as",    "at",     "be",     "by",      "for",    "from",  "in",     "is",     "it",
+    "of",    "on",     "or",     "that",    "the",    "this",  "to",     "was",    "with"};
+
+/**
+ * @brief unicode61 token characters: categories L*, N* and Co
+ */
+static bool isTokenCharacter(char32_t c) {
+    return (U_GET_GC_MASK(c) & (U_GC_L_MASK | U_GC_N_MASK | U_GC_CO_MASK)) != 0;
+}
+
+/**
+ * @brief Latin letters, the only ones whose diacritics the index removes
+ */
+static bool isLatin(UChar32 c) {
+    return c < 0x250 || (c >= 0x1E00 && c < 0x1F00);
+}
+
+QueryCompiler::QueryCompiler() : database(nullptr), countStatement(nullptr) {}
+
+QueryCompiler::~QueryCompiler() {
+    sqlite3_finalize(countStatement);
+}
+
+bool QueryCompiler::open(sqlite3* database, const char* table) {
+    sqlite3_finalize(countStatement);
+    countStatement = nullptr;
+    this->database = database;
+    this->table = table;
+    if (!database)
+        return false;
+
+    // The temp schema is private to this connection and vanishes with it
+    string vocabTable = string(table) + "_terms";
+    string sql = "CREATE VIRTUAL TABLE IF NOT EXISTS temp." + vocabTable +
+                 " USING fts5vocab(main, " + table + ", row);";
+    if (sqlite3_exec(database, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "Error creating term counts: " << sqlite3_errmsg(database) << endl;
+        return false;
+    }
+
+    sql = "SELECT doc FROM temp." + vocabTable + " WHERE term = ?;";
+    if (sqlite3_prepare_v3(database,
+                           sql.c_str(),
+                           -1,
+                           SQLITE_PREPARE_PERSISTENT,
+                           &countStatement,
+                           nullptr) != SQLITE_OK) {
+        cerr << "Error preparing term counts: " << sqlite3_errmsg(database) << endl;
+        countStatement = nullptr;
+        return false;
+    }
+    return true;
+}
+
+int64_t QueryCompiler::getDocumentCount(const string& term) const {
+    if (!countStatement)
+        return -1;
+
+    lock_guard<mutex> guard(countLock);
+    sqlite3_bind_text(countStatement, 1, term.c_str(), (int)term.size(), SQLITE_STATIC);
+    int64_t count = 0;
+    int result = sqlite3_step(countStatement);
+    if (result == SQLITE_ROW)
+        count = sqlite3_column_int64(countStatement, 0);
+    else if (result != SQLITE_DONE)
+        count = -1;
+    sqlite3_reset(countStatement);
+    sqlite3_clear_bindings(countStatement);
+    return count;
+}
+
+u32string QueryCompiler::decode(const string& text) {
+    icu::UnicodeString unicodeText = icu::UnicodeString::fromUTF8(text);
+    u32string text32(unicodeText.countChar32(), U'\0');
+    UErrorCode status = U_ZERO_ERROR;
+    if (!text32.empty())
+        unicodeText.toUTF32((UChar32*)&text32[0], (int32_t)text32.size(), status);
+    return text32;
+}
+
+void QueryCompiler::tokenize(const u32string& text,
+                             const function<void(const u32string&)>& onToken) {
+    u32string token;
+    for (char32_t c : text) {
+        if (isTokenCharacter(c)) {
+            token.push_back(u_tolower(c));
+        } else if (!token.empty()) {
+            onToken(token);
+            token.clear();
+        }
+    }
+    if (!token.empty())
+        onToken(token);
+}
+
+string QueryCompiler::fold(const u32string& token) {
+    UErrorCode status = U_ZERO_ERROR;
+    const icu::Normalizer2* nfd = icu::Normalizer2::getNFDInstance(status);
+    icu::UnicodeString decomposed =
+        icu::UnicodeString::fromUTF32((const UChar32*)token.data(), (int32_t)token.size());
+    if (U_SUCCESS(status))
+        decomposed = nfd->normalize(decomposed, status);
+    if (U_FAILURE(status))
+        decomposed = icu::UnicodeString::fromUTF32((const UChar32*)token.data(),
+                                                   (int32_t)token.size());
+
+    // Drops the combining marks of Latin letters, so "ñ" and "ü" fold to n and u
+    icu::UnicodeString folded;
+    UChar32 base = 0;
+    for (int32_t i = 0; i < decomposed.length();) {
+        UChar32 c = decomposed.char32At(i);
+        i += U16_LENGTH(c);
+        if (u_charType(c) == U_NON_SPACING_MARK && isLatin(base))
+            continue;
+        base = c;
+        folded.append(c);
+    }
+
+    string utf8;
+    folded.toUTF8String(utf8);
+    return utf8;
+}
+
+bool QueryCompiler::isStopword(const string& folded) {
+    return STOPWORDS.count(folded) != 0;
+}
+
+bool QueryCompiler::compile(const string& text,
+                            string& match,
+                            const ExpansionCounter& countExpansions,
+                            QueryStats* stats) const {
+    match.clear();
+
+    struct Term {
+        u32string token;
+        string folded;
+        int64_t documents;
+    };
+    vector<Term> terms;
+
+    u32string text32 = decode(text);
+
+    // A repeated token moves to the end, so the last one typed stays last
+    tokenize(text32, [&](const u32string& token) {
+        string folded = fold(token);
+        terms.erase(remove_if(terms.begin(),
+                              terms.end(),
+                              [&](const Term& term) { return term.folded == folded; }),
+                    terms.end());
+        terms.push_back({token, folded, 0});
+    });
+    if (terms.empty())
+        return false;
+    string lastFolded = terms.back().folded;
+
+    // Stopwords go unless nothing else is left
+    auto isStopTerm = [](const Term& term) { return isStopword(term.folded); };
+    if (!all_of(terms.begin(), terms.end(), isStopTerm))
+        terms.erase(remove_if(terms.begin(), terms.end(), isStopTerm), terms.end());
+
+    // A last token still being typed (no separator after it) is a prefix,
+    // unless it would expand to too many words
+    Term prefixTerm;
+    bool prefix = isTokenCharacter(text32.back()) && terms.back().folded == lastFolded;
+    if (prefix && countExpansions)
+        prefix = countExpansions(terms.back().token, MAX_PREFIX_EXPANSION) <= MAX_PREFIX_EXPANSION;
+    if (prefix) {
+        prefixTerm = terms.back();
+        terms.pop_back();
+    }
+
+    // Rarest first; a term no document contains rules the whole query out
+    for (Term& term : terms) {
+        term.documents = getDocumentCount(term.folded);
+        if (term.documents == 0)
+            return false;
+    }
+    stable_sort(terms.begin(), terms.end(), [](const Term& a, const Term& b) {
+        return a.documents < b.documents;
+    });
+    if (terms.size() > MAX_QUERY_TERMS)
+        terms.resize(MAX_QUERY_TERMS);
+
+    // Tokens hold no quotes, so quoting makes each one a single literal term
+    for (const Term& term : terms)
+        match += (match.empty() ? "\"" : " \"") + term.folded + "\"";
+    if (prefix)
+        match += (match.empty() ? "\"" : " \"") + prefixTerm.folded + "\"*";
+
+    if (stats) {
+        *stats = QueryStats();
+        stats->terms = terms.size();
+        if (!terms.empty()) {
+            stats->rarestTerm = terms.front().folded;
+            stats->rarestDocuments = terms.front().documents;
+        }
+        if (prefix)
+            stats->prefix = prefixTerm.folded;
+    }
+    return !match.empty();
+}
+
+/**
+ * @brief Runs a query returning one integer, or -1 on errors and no rows
+ */
+static int64_t queryInteger(sqlite3* database,
+                            const string& sql,
+                            const vector<string>& textArguments,
+                            int64_t integerArgument = -1) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        return -1;
+    int index = 1;
+    for (const string& argument : textArguments)
+        sqlite3_bind_text(stmt, index++, argument.c_str(), -1, SQLITE_TRANSIENT);
+    if (integerArgument >= 0)
+        sqlite3_bind_int64(stmt, index, integerArgument);
+
+    int64_t value = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+        value = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+int64_t QueryCompiler::estimateHits(const string& match,
+                                    const QueryStats& stats,
+                                    bool& exact) const {
+    exact = false;
+    if (!countStatement || match.empty())
+        return -1;
+
+    // One term: the length of its doclist
+    if (stats.terms == 1 && stats.prefix.empty()) {
+        exact = stats.rarestDocuments >= 0;
+        return stats.rarestDocuments;
+    }
+
+    // A lone prefix: the union of its expansions, as if they were independent,
+    // within the largest rowid (no fewer than the documents there are)
+    if (stats.terms == 0) {
+        string sql = "SELECT rowid FROM " + table + " ORDER BY rowid DESC LIMIT 1;";
+        double documents = (double)queryInteger(database, sql, {});
+        sql = "SELECT doc FROM temp." + table + "_terms WHERE term >= ? AND term < ?;";
+        sqlite3_stmt* stmt;
+        if (documents <= 0 || sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, nullptr) !=
+                                  SQLITE_OK)
+            return -1;
+        string end = stats.prefix + "\xF4\x8F\xBF\xBF";
+        sqlite3_bind_text(stmt, 1, stats.prefix.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, end.c_str(), -1, SQLITE_TRANSIENT);
+
+        double missed = 1.0;
+        int64_t expansions = 0, largest = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            int64_t doc = sqlite3_column_int64(stmt, 0);
+            missed *= 1.0 - min(1.0, doc / documents);
+            largest = max(largest, doc);
+            expansions++;
+        }
+        sqlite3_finalize(stmt);
+
+        exact = expansions == 1;
+        return max(largest, (int64_t)(documents * (1.0 - missed) + 0.5));
+    }
+    if (stats.rarestDocuments <= 0)
+        return stats.rarestDocuments;
+
+    // The rarest term's first documents, up to rowid last, are a sample of all
+    // the documents the query can match; FTS5 stops each doclist at last
+    int64_t sample = min(stats.rarestDocuments, HIT_SAMPLE);
+    string sql = "SELECT rowid FROM " + table + " WHERE " + table +
+                 " MATCH ? ORDER BY rowid LIMIT 1 OFFSET ?;";
+    int64_t last = queryInteger(database, sql, {"\"" + stats.rarestTerm + "\""}, sample - 1);
+    if (last < 0)
+        return -1;
+
+    sql = "SELECT count(*) FROM " + table + " WHERE " + table + " MATCH ? AND rowid <= ?;";
+    int64_t sampleHits = queryInteger(database, sql, {match}, last);
+    if (sampleHits < 0)
+        return -1;
+
+    exact = sample == stats.rarestDocuments;
+    return exact ? sampleHits : (sampleHits * stats.rarestDocuments + sample / 2) / sample;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file QueryCompiler.h
+ * @brief Compiles user search text into a well-formed FTS5 MATCH expression
+ * @version 1.0
+ *
+ * Binding the raw text to MATCH lets quotes, hyphens and colons through as
+ * FTS5 syntax, so such queries fail to parse and return nothing. The
+ * compiler splits the text with the index tokenizer's rules (unicode61:
+ * letters, numbers and private-use code points, diacritics removed), drops
+ * stopwords and quotes every term, so any input yields a valid expression.
+ * Terms are ordered rarest first from the fts5vocab document counts, and
+ * the last one becomes a prefix query while the autocomplete vocabulary
+ * expands it to few enough words.
+ */
+
+#ifndef QUERYCOMPILER_H
+#define QUERYCOMPILER_H
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Counts vocabulary words starting with prefix, stopping past limit
+typedef std::function<size_t(const std::u32string& prefix, size_t limit)> ExpansionCounter;
+
+/**
+ * @brief What compile() learned about a query, for counting its hits
+ */
+struct QueryStats {
+    // Plain (non-prefix) terms in the expression
+    size_t terms = 0;
+    // Plain term with the fewest documents, and how many contain it (-1: unknown)
+    std::string rarestTerm;
+    int64_t rarestDocuments = -1;
+    // Folded prefix term, empty if none
+    std::string prefix;
+};
+
+class QueryCompiler {
+  public:
+    QueryCompiler();
+    ~QueryCompiler();
+    QueryCompiler(const QueryCompiler&) = delete;
+    QueryCompiler& operator=(const QueryCompiler&) = delete;
+
+    /**
+     * @name open
+     * @brief Attaches the document counts of an FTS5 table
+     *
+     * Creates a temporary fts5vocab table on the connection. Without it,
+     * compile() keeps the terms in typed order.
+     *
+     * @param database Open index database
+     * @param table FTS5 table name
+     * @return True if the counts are available
+     */
+    bool open(sqlite3* database, const char* table);
+
+    /**
+     * @name compile
+     * @brief Builds the MATCH expression for a search text
+     * @param text Search text as typed (UTF-8)
+     * @param match Output expression, empty if nothing is searchable
+     * @param countExpansions Optional; without it the last term is always a prefix
+     * @param stats Optional output, for estimateHits()
+     * @return False if the text cannot match any document: no terms, or a
+     *         term that no document contains
+     */
+    bool compile(const std::string& text,
+                 std::string& match,
+                 const ExpansionCounter& countExpansions = nullptr,
+                 QueryStats* stats = nullptr) const;
+
+    /**
+     * @name estimateHits
+     * @brief Counts the documents a compiled query matches, without ranking them
+     *
+     * One plain term: its document count, exact. Several terms: the
+     * expression is counted over the first documents (by rowid) of the
+     * rarest term, then scaled to all of its documents; exact when that
+     * term has few enough documents. A lone prefix: the union of its
+     * expansions' documents, estimated as if they occurred independently.
+     *
+     * @param match Expression from compile()
+     * @param stats Statistics from the same compile() call
+     * @param exact Output, true if the count is exact
+     * @return Document count, -1 if unknown
+     */
+    int64_t estimateHits(const std::string& match, const QueryStats& stats, bool& exact) const;
+
+    /**
+     * @name getDocumentCount
+     * @brief Documents containing a folded term, or -1 without counts
+     */
+    int64_t getDocumentCount(const std::string& term) const;
+
+    /**
+     * @name decode
+     * @brief Converts UTF-8 to UTF-32; invalid bytes become U+FFFD, a separator
+     */
+    static std::u32string decode(const std::string& text);
+
+    /**
+     * @name tokenize
+     * @brief Splits text like the index tokenizer
+     * @param text Text (UTF-32)
+     * @param onToken Called with each token, lowercased but not folded
+     */
+    static void tokenize(const std::u32string& text,
+                         const std::function<void(const std::u32string&)>& onToken);
+
+    /**
+     * @name fold
+     * @brief Removes diacritics like remove_diacritics 2 ("canción" → "cancion")
+     * @param token Lowercase token
+     * @return Folded token (UTF-8), as stored in the index
+     */
+    static std::string fold(const std::u32string& token);
+
+    static bool isStopword(const std::string& folded);
+
+  private:
+    sqlite3* database;
+    std::string table;
+    // Looks up one term in the temporary fts5vocab table; shared by request threads
+    sqlite3_stmt* countStatement;
+    mutable std::mutex countLock;
+};
+
+#endif
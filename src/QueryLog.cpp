@@ -0,0 +1,123 @@
+/**
+ * @file QueryLog.cpp
+ * @brief Compact binary log of served queries, for replay by edabench
+ * @version 1.0
+ */
+
+#include "QueryLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+static const char QUERYLOG_MAGIC[8] = {'E', 'D', 'A', 'Q', 'L', 'O', 'G', '1'};
+
+static uint64_t currentTimestamp() {
+    return chrono::duration_cast<chrono::microseconds>(
+               chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+static void writeVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+static bool readVarint(istream& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == EOF)
+            return false;
+        value |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+QueryLog::QueryLog(const string& path) {
+    file.open(path, ios::binary | ios::trunc);
+    if (file.fail()) {
+        cerr << "Error opening query log: " << path << endl;
+        return;
+    }
+
+    lastTimestamp = currentTimestamp();
+
+    string header(QUERYLOG_MAGIC, sizeof(QUERYLOG_MAGIC));
+    for (int i = 0; i < 8; i++)
+        header += (char)(lastTimestamp >> (8 * i));
+    file.write(header.data(), header.size());
+}
+
+QueryLog::~QueryLog() {
+    if (file.is_open())
+        file.close();
+}
+
+bool QueryLog::isOpen() {
+    return file.is_open();
+}
+
+void QueryLog::append(QueryLogRoute route, const string& query) {
+    if (!file.is_open())
+        return;
+
+    string record;
+    record.reserve(query.size() + 8);
+
+    lock_guard<mutex> guard(lock);
+
+    // Clock may step back between threads; deltas never go negative
+    uint64_t timestamp = max(currentTimestamp(), lastTimestamp);
+    writeVarint(record, timestamp - lastTimestamp);
+    record += (char)route;
+    writeVarint(record, query.size());
+    record += query;
+    lastTimestamp = timestamp;
+
+    file.write(record.data(), record.size());
+}
+
+bool QueryLog::read(const string& path, vector<QueryLogEntry>& entries) {
+    ifstream file(path, ios::binary);
+    if (file.fail()) {
+        cerr << "Error opening query log: " << path << endl;
+        return false;
+    }
+
+    // Checks header
+    char header[16];
+    if (!file.read(header, sizeof(header)) ||
+        !equal(QUERYLOG_MAGIC, QUERYLOG_MAGIC + sizeof(QUERYLOG_MAGIC), header)) {
+        cerr << "Not a query log: " << path << endl;
+        return false;
+    }
+
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 8; i++)
+        timestamp |= (uint64_t)(unsigned char)header[8 + i] << (8 * i);
+
+    // Reads records until end of file (a truncated last record is dropped)
+    uint64_t delta, length;
+    while (readVarint(file, delta)) {
+        int route = file.get();
+        if (route == EOF || route >= QUERYLOG_ROUTES || !readVarint(file, length))
+            break;
+
+        string query(length, '\0');
+        if (!file.read(&query[0], length))
+            break;
+
+        timestamp += delta;
+        entries.push_back({timestamp, (QueryLogRoute)route, query});
+    }
+
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file QueryLog.h
+ * @brief Compact binary log of served queries, for replay by edabench
+ * @version 1.0
+ *
+ * File layout: "EDAQLOG1", start timestamp (8 bytes, little endian,
+ * microseconds since epoch), then one record per request:
+ * varint time delta (microseconds), route (1 byte), varint length, query bytes.
+ */
+
+#ifndef QUERYLOG_H
+#define QUERYLOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum QueryLogRoute : uint8_t {
+    QUERYLOG_SEARCH,
+    QUERYLOG_PREDICT,
+    QUERYLOG_LUCKY,
+    QUERYLOG_IMAGE,
+    QUERYLOG_OTHER,
+    QUERYLOG_ROUTES
+};
+
+struct QueryLogEntry {
+    uint64_t timestamp;  // microseconds since epoch
+    QueryLogRoute route;
+    std::string query;  // search text, or the path for images and other routes
+};
+
+class QueryLog {
+  public:
+    QueryLog(const std::string& path);
+    ~QueryLog();
+
+    bool isOpen();
+
+    /**
+     * @name append
+     * @brief Records a request (thread safe)
+     * @param route The route that served the request
+     * @param query Search text, or the path for images and other routes
+     */
+    void append(QueryLogRoute route, const std::string& query);
+
+    /**
+     * @name read
+     * @brief Reads a whole log file
+     * @param path The log file
+     * @param entries Output entries, in recording order
+     * @return True if the file was read successfully
+     */
+    static bool read(const std::string& path, std::vector<QueryLogEntry>& entries);
+
+  private:
+    std::ofstream file;
+    std::mutex lock;
+    uint64_t lastTimestamp;
+};
+
+#endif
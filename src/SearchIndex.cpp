@@ -0,0 +1,133 @@
+/**
+ * @file SearchIndex.cpp
+ * @brief Index database layout and access shared by mkindex and edahttpd
+ * @version 1.0
+ */
+
+#include "SearchIndex.h"
+
+#include <codecvt>
+#include <iostream>
+#include <locale>
+
+#include "TextProcessing.h"
+#include "Trace.h"
+
+using namespace std;
+
+IndexNames getIndexNames(bool imageMode) {
+    if (imageMode) {
+        return {"images.db",
+                "images_index",
+                "images_vocab.db",
+                "images_vocab",
+                "images_vocab.dawg",
+                "images_bigrams",
+                "images_phrases",
+                "images_vocab.symspell"};
+    }
+    return {"index.db",
+            "webpage_index",
+            "index_vocab.db",
+            "webpage_vocab",
+            "index_vocab.dawg",
+            "webpage_bigrams",
+            "webpage_phrases",
+            "index_vocab.symspell"};
+}
+
+bool readVocabulary(sqlite3* database,
+                    const char* vocabTable,
+                    const function<void(const u32string&)>& onWord) {
+    TRACE_SPAN("readVocabulary");
+
+    // Pointer for read statement
+    sqlite3_stmt* stmt;
+    // Statement structure
+    string sql = string("SELECT vocabulary FROM ") + vocabTable;
+
+    // Compiles SQL statement
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cerr << "Failed to prepare statement: " << sqlite3_errmsg(database) << endl;
+        return false;
+    }
+
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* content = (const char*)sqlite3_column_text(stmt, 0);
+        if (content)
+            forEachWord(converter.from_bytes(content), onWord);
+    }
+
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool readNewVocabulary(sqlite3* database,
+                       const char* vocabTable,
+                       sqlite3_int64& lastRowid,
+                       const function<void(const u32string&)>& onWord) {
+    TRACE_SPAN("readNewVocabulary");
+
+    sqlite3_stmt* stmt;
+    string sql =
+        string("SELECT rowid, vocabulary FROM ") + vocabTable + " WHERE rowid > ? ORDER BY rowid;";
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK)
+        return false;
+    sqlite3_bind_int64(stmt, 1, lastRowid);
+
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        lastRowid = sqlite3_column_int64(stmt, 0);
+        const char* content = (const char*)sqlite3_column_text(stmt, 1);
+        if (content)
+            forEachWord(converter.from_bytes(content), onWord);
+    }
+
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool readBigrams(sqlite3* database,
+                 const char* bigramTable,
+                 const function<void(const string&, const string&, uint32_t)>& onBigram) {
+    TRACE_SPAN("readBigrams");
+
+    sqlite3_stmt* stmt;
+    string sql = string("SELECT first, second, count FROM ") + bigramTable +
+                 " ORDER BY first, count DESC;";
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK)
+        return false;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* first = (const char*)sqlite3_column_text(stmt, 0);
+        const char* second = (const char*)sqlite3_column_text(stmt, 1);
+        if (first && second)
+            onBigram(first, second, (uint32_t)sqlite3_column_int64(stmt, 2));
+    }
+
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool readPhrases(sqlite3* database,
+                 const char* phraseTable,
+                 const function<void(const string&, uint32_t)>& onPhrase) {
+    TRACE_SPAN("readPhrases");
+
+    sqlite3_stmt* stmt;
+    string sql = string("SELECT phrase, count FROM ") + phraseTable + ";";
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK)
+        return false;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* phrase = (const char*)sqlite3_column_text(stmt, 0);
+        if (phrase)
+            onPhrase(phrase, (uint32_t)sqlite3_column_int64(stmt, 1));
+    }
+
+    sqlite3_finalize(stmt);
+    return true;
+}
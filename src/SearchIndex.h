@@ -0,0 +1,97 @@
+/**
+ * @file SearchIndex.h
+ * @brief Index database layout and access shared by mkindex and edahttpd
+ * @version 1.0
+ */
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @brief File and table names of one index mode
+ */
+struct IndexNames {
+    const char* indexFile;
+    const char* indexTable;
+    const char* vocabFile;
+    const char* vocabTable;
+    // Vocabulary automaton (see Dawg.h)
+    const char* dawgFile;
+    // Top followers of each word, in the vocabulary database
+    const char* bigramTable;
+    // Frequent 2-3 word phrases (see Phrases.h), in the vocabulary database
+    const char* phraseTable;
+    // Spelling corrections of the index terms (see SymSpell.h)
+    const char* spellingFile;
+};
+
+/**
+ * @name getIndexNames
+ * @brief Returns the database files and tables used by a mode
+ * @param imageMode True for the image index, false for HTML pages
+ * @return File and table names
+ */
+IndexNames getIndexNames(bool imageMode);
+
+/**
+ * @name readVocabulary
+ * @brief Tokenizes every vocabulary row, as forEachWord does
+ * @param database Open vocabulary database
+ * @param vocabTable Vocabulary table name
+ * @param onWord Called with each word (lowercase UTF-32)
+ * @return True if the table could be read
+ */
+bool readVocabulary(sqlite3* database,
+                    const char* vocabTable,
+                    const std::function<void(const std::u32string&)>& onWord);
+
+/**
+ * @name readNewVocabulary
+ * @brief Tokenizes the vocabulary rows added after a given rowid
+ *
+ * mkindex -watch appends one row per batch of new words, so following the
+ * largest rowid picks up freshly indexed words.
+ *
+ * @param database Open vocabulary database
+ * @param vocabTable Vocabulary table name
+ * @param lastRowid Largest rowid already read, updated to the largest read now
+ * @param onWord Called with each word (lowercase UTF-32)
+ * @return True if the table could be read
+ */
+bool readNewVocabulary(sqlite3* database,
+                       const char* vocabTable,
+                       sqlite3_int64& lastRowid,
+                       const std::function<void(const std::u32string&)>& onWord);
+
+/**
+ * @name readBigrams
+ * @brief Reads the bigram table, most frequent follower of each word first
+ * @param database Open vocabulary database
+ * @param bigramTable Bigram table name
+ * @param onBigram Called with each (first, second, count)
+ * @return False if the table is missing (mkindex -skipvocab or an older index)
+ */
+bool readBigrams(
+    sqlite3* database,
+    const char* bigramTable,
+    const std::function<void(const std::string&, const std::string&, uint32_t)>& onBigram);
+
+/**
+ * @name readPhrases
+ * @brief Reads the phrase table
+ * @param database Open vocabulary database
+ * @param phraseTable Phrase table name
+ * @param onPhrase Called with each (phrase, count)
+ * @return False if the table is missing (mkindex -skipvocab or an older index)
+ */
+bool readPhrases(sqlite3* database,
+                 const char* phraseTable,
+                 const std::function<void(const std::string&, uint32_t)>& onPhrase);
+
+#endif
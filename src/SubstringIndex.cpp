@@ -0,0 +1,247 @@
+/**
+ * @file SubstringIndex.cpp
+ * @brief Suffix array over the vocabulary for infix autocomplete
+ * @version 1.0
+ */
+
+#include "SubstringIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Text layout: word 0x01 word 0x01 ... 0x00
+static const char SENTINEL = '\0';
+static const char SEPARATOR = '\1';
+// Suffixes inspected per requested suggestion before giving up
+static const size_t SCAN_FACTOR = 64;
+
+//================================ SA-IS ================================//
+
+/**
+ * @brief Bucket boundaries per symbol: starts (heads) or ends (tails)
+ */
+template <typename Symbol>
+static void getBuckets(const Symbol* text,
+                       int32_t n,
+                       int32_t alphabetSize,
+                       vector<int32_t>& buckets,
+                       bool ends) {
+    buckets.assign(alphabetSize, 0);
+    for (int32_t i = 0; i < n; i++)
+        buckets[(int32_t)text[i]]++;
+
+    int32_t sum = 0;
+    for (int32_t c = 0; c < alphabetSize; c++) {
+        sum += buckets[c];
+        buckets[c] = ends ? sum : sum - buckets[c];
+    }
+}
+
+/**
+ * @brief Induces L-type then S-type suffixes from LMS suffixes placed in sa
+ */
+template <typename Symbol>
+static void induceSort(const Symbol* text,
+                       int32_t* sa,
+                       int32_t n,
+                       int32_t alphabetSize,
+                       const vector<bool>& sType,
+                       vector<int32_t>& buckets) {
+    getBuckets(text, n, alphabetSize, buckets, false);
+    for (int32_t i = 0; i < n; i++) {
+        int32_t j = sa[i] - 1;
+        if (sa[i] > 0 && !sType[j])
+            sa[buckets[(int32_t)text[j]]++] = j;
+    }
+
+    getBuckets(text, n, alphabetSize, buckets, true);
+    for (int32_t i = n - 1; i >= 0; i--) {
+        int32_t j = sa[i] - 1;
+        if (sa[i] > 0 && sType[j])
+            sa[--buckets[(int32_t)text[j]]] = j;
+    }
+}
+
+/**
+ * @brief Sorts all suffixes of text (SA-IS, Nong, Zhang and Chan)
+ *
+ * text[n - 1] must be a unique, smallest sentinel.
+ */
+template <typename Symbol>
+static void buildSuffixArray(const Symbol* text, int32_t* sa, int32_t n, int32_t alphabetSize) {
+    if (n == 1) {
+        sa[0] = 0;
+        return;
+    }
+
+    // Classifies suffixes: S if smaller than the next suffix, L otherwise
+    vector<bool> sType(n);
+    sType[n - 1] = true;
+    for (int32_t i = n - 2; i >= 0; i--)
+        sType[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && sType[i + 1]);
+    auto isLms = [&](int32_t i) { return i > 0 && sType[i] && !sType[i - 1]; };
+
+    // Step 1: sorts LMS substrings by placing them at their bucket ends and inducing
+    vector<int32_t> buckets;
+    fill(sa, sa + n, -1);
+    getBuckets(text, n, alphabetSize, buckets, true);
+    for (int32_t i = 1; i < n; i++) {
+        if (isLms(i))
+            sa[--buckets[(int32_t)text[i]]] = i;
+    }
+    induceSort(text, sa, n, alphabetSize, sType, buckets);
+
+    // Compacts sorted LMS positions to the front
+    int32_t lmsCount = 0;
+    for (int32_t i = 0; i < n; i++) {
+        if (isLms(sa[i]))
+            sa[lmsCount++] = sa[i];
+    }
+
+    // Names LMS substrings; equal substrings share a name. Names are stored
+    // at sa[lmsCount + position / 2], which never collide since LMS positions
+    // are at least two apart
+    fill(sa + lmsCount, sa + n, -1);
+    int32_t name = 0;
+    int32_t previous = -1;
+    for (int32_t i = 0; i < lmsCount; i++) {
+        int32_t position = sa[i];
+        bool equal = previous >= 0;
+        for (int32_t d = 0; equal; d++) {
+            if (text[position + d] != text[previous + d] ||
+                sType[position + d] != sType[previous + d]) {
+                equal = false;
+            } else if (d > 0 && (isLms(position + d) || isLms(previous + d))) {
+                equal = isLms(position + d) && isLms(previous + d);
+                break;
+            }
+        }
+        if (!equal)
+            name++;
+        previous = position;
+        sa[lmsCount + position / 2] = name - 1;
+    }
+    for (int32_t i = n - 1, j = n - 1; i >= lmsCount; i--) {
+        if (sa[i] >= 0)
+            sa[j--] = sa[i];
+    }
+
+    // Step 2: sorts the reduced string, recursing while names repeat
+    int32_t* reduced = sa + n - lmsCount;
+    int32_t* reducedSa = sa;
+    if (name < lmsCount) {
+        buildSuffixArray(reduced, reducedSa, lmsCount, name);
+    } else {
+        for (int32_t i = 0; i < lmsCount; i++)
+            reducedSa[reduced[i]] = i;
+    }
+
+    // Step 3: maps reduced suffixes back to LMS positions and induces the rest
+    for (int32_t i = 1, j = 0; i < n; i++) {
+        if (isLms(i))
+            reduced[j++] = i;
+    }
+    vector<int32_t> sortedLms(lmsCount);
+    for (int32_t i = 0; i < lmsCount; i++)
+        sortedLms[i] = reduced[reducedSa[i]];
+
+    fill(sa, sa + n, -1);
+    getBuckets(text, n, alphabetSize, buckets, true);
+    for (int32_t i = lmsCount - 1; i >= 0; i--)
+        sa[--buckets[(int32_t)text[sortedLms[i]]]] = sortedLms[i];
+    induceSort(text, sa, n, alphabetSize, sType, buckets);
+}
+
+//=============================== INDEX ================================//
+
+size_t SubstringIndex::build(const vector<string>& words) {
+    text.clear();
+    wordCount = 0;
+    for (const string& word : words) {
+        if (word.empty() || word.find(SEPARATOR) != string::npos ||
+            word.find(SENTINEL) != string::npos)
+            continue;
+
+        wordCount++;
+        text += word;
+        text += SEPARATOR;
+    }
+    text += SENTINEL;
+    text.shrink_to_fit();
+
+    suffixArray.assign(text.size(), 0);
+    buildSuffixArray((const uint8_t*)text.data(), suffixArray.data(), (int32_t)text.size(), 256);
+
+    return wordCount;
+}
+
+void SubstringIndex::findRange(const string& pattern, size_t& begin, size_t& end) const {
+    // Compares the first pattern.size() bytes of a suffix with the pattern
+    auto compare = [&](int32_t position) {
+        size_t length = min(pattern.size(), text.size() - position);
+        int result = memcmp(text.data() + position, pattern.data(), length);
+        if (result == 0 && length < pattern.size())
+            return -1;
+        return result;
+    };
+
+    auto first = partition_point(suffixArray.begin(), suffixArray.end(), [&](int32_t position) {
+        return compare(position) < 0;
+    });
+    auto last = partition_point(first, suffixArray.end(), [&](int32_t position) {
+        return compare(position) == 0;
+    });
+    begin = first - suffixArray.begin();
+    end = last - suffixArray.begin();
+}
+
+uint32_t SubstringIndex::wordStart(uint32_t position) const {
+    // Words are short, so scanning back beats a binary search over offsets
+    while (position > 0 && text[position - 1] != SEPARATOR)
+        position--;
+    return position;
+}
+
+size_t SubstringIndex::collectInfixSuggestions(const string& pattern,
+                                               size_t maxSuggestions,
+                                               vector<string>& suggestions) const {
+    if (pattern.empty() || maxSuggestions == 0 || !wordCount)
+        return 0;
+
+    size_t begin, end;
+    findRange(pattern, begin, end);
+
+    // Frequent patterns match millions of suffixes: only a bounded window is scanned
+    end = min(end, begin + SCAN_FACTOR * maxSuggestions);
+
+    // Words are deduplicated by their offset in text
+    vector<uint32_t> seen;
+    for (size_t i = begin; i < end && seen.size() < maxSuggestions; i++) {
+        uint32_t position = (uint32_t)suffixArray[i];
+        uint32_t start = wordStart(position);
+        if (start == position || find(seen.begin(), seen.end(), start) != seen.end())
+            continue;
+
+        seen.push_back(start);
+        size_t wordEnd = text.find(SEPARATOR, position);
+        suggestions.push_back(text.substr(start, wordEnd - start));
+    }
+
+    return seen.size();
+}
+
+size_t SubstringIndex::countOccurrences(const string& pattern) const {
+    size_t begin, end;
+    findRange(pattern, begin, end);
+    return end - begin;
+}
+
+size_t SubstringIndex::getWordCount() const {
+    return wordCount;
+}
+
+size_t SubstringIndex::getMemoryUsage() const {
+    return text.capacity() + suffixArray.capacity() * sizeof(int32_t);
+}
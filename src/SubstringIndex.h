@@ -0,0 +1,67 @@
+/**
+ * @file SubstringIndex.h
+ * @brief Suffix array over the vocabulary for infix autocomplete
+ * @version 1.0
+ *
+ * The words are concatenated, each followed by a separator byte, and every
+ * suffix of that text is sorted once (SA-IS, linear time). Suffixes starting
+ * with a pattern form a contiguous range found by binary search, so "sort"
+ * also finds "quicksort" and "mergesort".
+ */
+
+#ifndef SUBSTRINGINDEX_H
+#define SUBSTRINGINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SubstringIndex {
+  public:
+    /**
+     * @name build
+     * @brief Builds the suffix array over the given UTF-8 words
+     *
+     * Words containing the separator or sentinel bytes are skipped.
+     *
+     * @param words Vocabulary
+     * @return Number of words indexed
+     */
+    size_t build(const std::vector<std::string>& words);
+
+    /**
+     * @name collectInfixSuggestions
+     * @brief Appends up to maxSuggestions words containing pattern past their first byte
+     *
+     * Prefix hits are left out, since the prefix structures already return
+     * them first. Words ending with the pattern sort first, since the
+     * separator is the smallest byte.
+     *
+     * @param pattern UTF-8 substring
+     * @param maxSuggestions Maximum number of words
+     * @param suggestions Output words
+     * @return Number of words appended
+     */
+    size_t collectInfixSuggestions(const std::string& pattern,
+                                   size_t maxSuggestions,
+                                   std::vector<std::string>& suggestions) const;
+
+    /**
+     * @name countOccurrences
+     * @brief Number of positions where pattern occurs, across all words
+     */
+    size_t countOccurrences(const std::string& pattern) const;
+
+    size_t getWordCount() const;
+    size_t getMemoryUsage() const;
+
+  private:
+    void findRange(const std::string& pattern, size_t& begin, size_t& end) const;
+    uint32_t wordStart(uint32_t position) const;
+
+    std::string text;
+    std::vector<int32_t> suffixArray;
+    size_t wordCount = 0;
+};
+
+#endif
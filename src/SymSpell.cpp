@@ -0,0 +1,345 @@
+/**
+ * @file SymSpell.cpp
+ * @brief Symmetric-delete spelling correction over the index terms
+ * @version 1.0
+ */
+
+#include "SymSpell.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <codecvt>
+#include <cstring>
+#include <fstream>
+#include <locale>
+
+using namespace std;
+
+// File layout: magic, max distance, prefix length, word count, bucket count,
+// entry count, pool size, then wordStarts[words + 1], frequencies[words],
+// bucketStarts[buckets + 1], entries[entries] (word ids grouped by delete
+// hash bucket) and the words themselves as UTF-32 code points
+static const char SYMSPELL_MAGIC[8] = {'E', 'D', 'A', 'S', 'Y', 'M', 'S', '1'};
+static const size_t HEADER_SIZE = sizeof(SYMSPELL_MAGIC) + 6 * sizeof(uint32_t);
+// Longer words are left out; they are rarely typed and make deletes costly
+static const size_t MAX_WORD_LENGTH = 64;
+
+/**
+ * @brief Calls onHash with the FNV-1a hash of every string made by deleting
+ *        up to maxDeletes code points of text, text itself included
+ *
+ * Deleted positions are enumerated in increasing order and skipped while
+ * hashing, so no string is built. Deletes that come out equal ("aab" without
+ * either "a") are reported once per way of reaching them.
+ */
+template <typename Callback>
+static void forEachDeleteHash(const u32string& text, uint32_t maxDeletes, Callback onHash) {
+    size_t deleted[8];
+    maxDeletes = min<uint32_t>(maxDeletes, (uint32_t)(sizeof(deleted) / sizeof(deleted[0])));
+
+    auto hashKept = [&](size_t deletedCount) {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        size_t next = 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (next < deletedCount && deleted[next] == i) {
+                next++;
+                continue;
+            }
+            hash ^= (uint64_t)text[i];
+            hash *= 0x100000001B3ULL;
+        }
+        onHash(hash);
+    };
+
+    // Odometer over increasing position tuples, one length at a time
+    hashKept(0);
+    for (size_t count = 1; count <= maxDeletes && count < text.size(); count++) {
+        for (size_t i = 0; i < count; i++)
+            deleted[i] = i;
+        while (true) {
+            hashKept(count);
+            size_t i = count;
+            while (i > 0 && deleted[i - 1] == text.size() - count + i - 1)
+                i--;
+            if (i == 0)
+                break;
+            deleted[i - 1]++;
+            for (size_t j = i; j < count; j++)
+                deleted[j] = deleted[j - 1] + 1;
+        }
+    }
+}
+
+/**
+ * @brief Optimal string alignment distance, or limit + 1 once it must exceed limit
+ */
+static uint32_t editDistance(const char32_t* a,
+                             size_t aLength,
+                             const char32_t* b,
+                             size_t bLength,
+                             uint32_t limit) {
+    if ((aLength > bLength ? aLength - bLength : bLength - aLength) > limit)
+        return limit + 1;
+
+    // Three rows: two back (for transpositions), previous and current
+    static thread_local vector<uint32_t> rows;
+    rows.assign(3 * (bLength + 1), 0);
+    uint32_t* beforePrevious = rows.data();
+    uint32_t* previous = beforePrevious + bLength + 1;
+    uint32_t* current = previous + bLength + 1;
+    for (size_t j = 0; j <= bLength; j++)
+        previous[j] = (uint32_t)j;
+
+    for (size_t i = 1; i <= aLength; i++) {
+        current[0] = (uint32_t)i;
+        uint32_t rowMinimum = current[0];
+        for (size_t j = 1; j <= bLength; j++) {
+            uint32_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            uint32_t distance =
+                min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                distance = min(distance, beforePrevious[j - 2] + 1);
+            current[j] = distance;
+            rowMinimum = min(rowMinimum, distance);
+        }
+        if (rowMinimum > limit)
+            return limit + 1;
+
+        uint32_t* recycled = beforePrevious;
+        beforePrevious = previous;
+        previous = current;
+        current = recycled;
+    }
+    return min(previous[bLength], limit + 1);
+}
+
+//=============================== BUILDER ================================//
+
+SymSpellBuilder::SymSpellBuilder(uint32_t maxDistance, uint32_t prefixLength)
+    : maxDistance(maxDistance), prefixLength(max(prefixLength, maxDistance + 1)) {}
+
+void SymSpellBuilder::add(const string& word, uint32_t frequency) {
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+    u32string word32 = converter.from_bytes(word);
+    if (!word32.empty() && word32.size() <= MAX_WORD_LENGTH)
+        words.emplace_back(move(word32), frequency);
+}
+
+size_t SymSpellBuilder::getWordCount() const {
+    return words.size();
+}
+
+bool SymSpellBuilder::save(const string& path) {
+    // Hash of every prefix delete and the word it came from, once per pair
+    vector<pair<uint64_t, uint32_t>> deleteEntries;
+    for (uint32_t id = 0; id < words.size(); id++) {
+        forEachDeleteHash(words[id].first.substr(0, prefixLength),
+                          maxDistance,
+                          [&](uint64_t hash) { deleteEntries.emplace_back(hash, id); });
+    }
+    sort(deleteEntries.begin(), deleteEntries.end());
+    deleteEntries.erase(unique(deleteEntries.begin(), deleteEntries.end()), deleteEntries.end());
+
+    // About two entries per bucket; colliding deletes only add candidates,
+    // which the lookup discards by computing their distance
+    uint32_t bucketCount = 1;
+    while (bucketCount < deleteEntries.size() / 2)
+        bucketCount <<= 1;
+    uint32_t bucketMask = bucketCount - 1;
+
+    vector<uint32_t> bucketStarts(bucketCount + 1, 0);
+    for (auto& entry : deleteEntries)
+        bucketStarts[(entry.first & bucketMask) + 1]++;
+    for (uint32_t bucket = 0; bucket < bucketCount; bucket++)
+        bucketStarts[bucket + 1] += bucketStarts[bucket];
+    vector<uint32_t> entries(deleteEntries.size());
+    vector<uint32_t> fill(bucketStarts.begin(), bucketStarts.end() - 1);
+    for (auto& entry : deleteEntries)
+        entries[fill[entry.first & bucketMask]++] = entry.second;
+
+    vector<uint32_t> wordStarts;
+    vector<uint32_t> frequencies;
+    u32string pool;
+    for (auto& word : words) {
+        wordStarts.push_back((uint32_t)pool.size());
+        frequencies.push_back(word.second);
+        pool += word.first;
+    }
+    wordStarts.push_back((uint32_t)pool.size());
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (file.fail())
+        return false;
+
+    uint32_t header[6] = {maxDistance,
+                          prefixLength,
+                          (uint32_t)words.size(),
+                          bucketCount,
+                          (uint32_t)entries.size(),
+                          (uint32_t)pool.size()};
+    file.write(SYMSPELL_MAGIC, sizeof(SYMSPELL_MAGIC));
+    file.write((const char*)header, sizeof(header));
+    file.write((const char*)wordStarts.data(), wordStarts.size() * sizeof(uint32_t));
+    file.write((const char*)frequencies.data(), frequencies.size() * sizeof(uint32_t));
+    file.write((const char*)bucketStarts.data(), bucketStarts.size() * sizeof(uint32_t));
+    file.write((const char*)entries.data(), entries.size() * sizeof(uint32_t));
+    file.write((const char*)pool.data(), pool.size() * sizeof(char32_t));
+
+    return !file.fail();
+}
+
+//=============================== READER ================================//
+
+SymSpell::SymSpell() : data(nullptr), size(0), mapped(false), wordCount(0) {}
+
+SymSpell::~SymSpell() {
+    unload();
+}
+
+void SymSpell::unload() {
+#ifdef __linux__
+    if (mapped)
+        munmap((void*)data, size);
+#endif
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+    mapped = false;
+    wordCount = 0;
+}
+
+bool SymSpell::load(const string& path) {
+    unload();
+
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+        void* address = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (address != MAP_FAILED) {
+            data = (const uint8_t*)address;
+            size = (size_t)status.st_size;
+            mapped = true;
+        }
+    }
+    close(fd);
+    if (!mapped)
+        return false;
+#else
+    ifstream file(path, ios::binary);
+    if (file.fail())
+        return false;
+    buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    uint32_t header[6];
+    if (size < HEADER_SIZE || memcmp(data, SYMSPELL_MAGIC, sizeof(SYMSPELL_MAGIC)) != 0) {
+        unload();
+        return false;
+    }
+    memcpy(header, data + sizeof(SYMSPELL_MAGIC), sizeof(header));
+    uint32_t bucketCount = header[3];
+    uint64_t expectedSize = HEADER_SIZE + ((uint64_t)header[2] + 1 + header[2] + bucketCount + 1 +
+                                           header[4] + header[5]) *
+                                              sizeof(uint32_t);
+    if (expectedSize != size || bucketCount == 0 || (bucketCount & (bucketCount - 1)) != 0) {
+        unload();
+        return false;
+    }
+
+    maxDistance = header[0];
+    prefixLength = header[1];
+    bucketMask = bucketCount - 1;
+    entryCount = header[4];
+    poolSize = header[5];
+    wordStarts = (const uint32_t*)(data + HEADER_SIZE);
+    frequencies = wordStarts + header[2] + 1;
+    bucketStarts = frequencies + header[2];
+    entries = bucketStarts + bucketCount + 1;
+    pool = (const char32_t*)(entries + entryCount);
+
+    // Offsets are checked again per lookup; only the totals are read here,
+    // so loading does not fault in the whole file
+    if (wordStarts[header[2]] != poolSize || bucketStarts[bucketCount] != entryCount) {
+        unload();
+        return false;
+    }
+    wordCount = header[2];
+    return true;
+}
+
+bool SymSpell::lookup(const string& term, string& correction, uint32_t& distance) const {
+    if (!wordCount || term.empty())
+        return false;
+
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+    u32string term32;
+    try {
+        term32 = converter.from_bytes(term);
+    } catch (const range_error&) {
+        return false;
+    }
+    if (term32.size() > MAX_WORD_LENGTH + maxDistance)
+        return false;
+
+    // A single edit already turns most short words into others
+    uint32_t limit = term32.size() <= 4 ? min(maxDistance, 1U) : maxDistance;
+
+    // Candidates are the words sharing a delete bucket with the term
+    static thread_local vector<uint32_t> candidates;
+    candidates.clear();
+    forEachDeleteHash(term32.substr(0, prefixLength), limit, [&](uint64_t hash) {
+        uint32_t bucket = (uint32_t)(hash & bucketMask);
+        uint32_t end = min(bucketStarts[bucket + 1], entryCount);
+        for (uint32_t entry = bucketStarts[bucket]; entry < end; entry++)
+            candidates.push_back(entries[entry]);
+    });
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+    uint32_t bestId = 0;
+    uint32_t bestDistance = limit + 1;
+    for (uint32_t id : candidates) {
+        if (id >= wordCount)
+            break;
+        uint32_t start = wordStarts[id];
+        uint32_t stop = wordStarts[id + 1];
+        if (start > stop || stop > poolSize)
+            continue;
+
+        // Ties go to the word more documents contain
+        uint32_t candidate =
+            editDistance(term32.data(), term32.size(), pool + start, stop - start, bestDistance);
+        if (candidate < bestDistance ||
+            (candidate == bestDistance && candidate <= limit &&
+             frequencies[id] > frequencies[bestId])) {
+            bestDistance = candidate;
+            bestId = id;
+        }
+    }
+
+    if (bestDistance > limit)
+        return false;
+    correction = converter.to_bytes(
+        u32string(pool + wordStarts[bestId], pool + wordStarts[bestId + 1]));
+    distance = bestDistance;
+    return true;
+}
+
+uint32_t SymSpell::getWordCount() const {
+    return wordCount;
+}
+
+size_t SymSpell::getMappedSize() const {
+    return size;
+}
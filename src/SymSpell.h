@@ -0,0 +1,118 @@
+/**
+ * @file SymSpell.h
+ * @brief Symmetric-delete spelling correction over the index terms
+ * @version 1.0
+ *
+ * Two words within edit distance d share a string obtained by deleting at
+ * most d characters from each (SymSpell). The builder stores, for every
+ * delete of every word's prefix, which words produce it; a lookup only
+ * generates the deletes of the misspelled term and verifies the few words
+ * they point to, instead of comparing against the whole vocabulary.
+ *
+ * The file is laid out as flat arrays, so edahttpd maps it and only the
+ * pages a lookup touches are read.
+ */
+
+#ifndef SYMSPELL_H
+#define SYMSPELL_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class SymSpellBuilder
+ * @brief Collects words with their frequencies and writes the delete index
+ */
+class SymSpellBuilder {
+  public:
+    /**
+     * @param maxDistance Largest edit distance a lookup may correct
+     * @param prefixLength Code points of each word that deletes are taken from
+     */
+    SymSpellBuilder(uint32_t maxDistance = 2, uint32_t prefixLength = 7);
+
+    /**
+     * @name add
+     * @brief Adds a word; each word must be added once
+     * @param word UTF-8 word, as stored in the index
+     * @param frequency Documents containing it; breaks ties between corrections
+     */
+    void add(const std::string& word, uint32_t frequency);
+
+    /**
+     * @name save
+     * @brief Generates the deletes and writes the index
+     * @param path Output file
+     * @return True if the file was written
+     */
+    bool save(const std::string& path);
+
+    size_t getWordCount() const;
+
+  private:
+    uint32_t maxDistance;
+    uint32_t prefixLength;
+    std::vector<std::pair<std::u32string, uint32_t>> words;
+};
+
+/**
+ * @class SymSpell
+ * @brief Read-only delete index mapped from the file written by SymSpellBuilder
+ */
+class SymSpell {
+  public:
+    SymSpell();
+    ~SymSpell();
+    SymSpell(const SymSpell&) = delete;
+    SymSpell& operator=(const SymSpell&) = delete;
+
+    /**
+     * @name load
+     * @brief Maps an index file (reads it where mmap is unavailable)
+     * @param path File written by SymSpellBuilder::save
+     * @return True if the file is a valid index
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @name lookup
+     * @brief Finds the closest known word, the most frequent among equals
+     *
+     * Terms of up to 4 code points are corrected by at most one edit.
+     *
+     * @param term Folded UTF-8 term
+     * @param correction Output word
+     * @param distance Output edit distance (optimal string alignment), 0 if known
+     * @return False if no word is close enough
+     */
+    bool lookup(const std::string& term, std::string& correction, uint32_t& distance) const;
+
+    uint32_t getWordCount() const;
+    size_t getMappedSize() const;
+
+  private:
+    void unload();
+
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+    // Fallback storage when the file is read instead of mapped
+    std::vector<uint8_t> buffer;
+
+    uint32_t maxDistance;
+    uint32_t prefixLength;
+    uint32_t wordCount;
+    uint32_t bucketMask;
+    // Views into data; see the layout in SymSpell.cpp
+    const uint32_t* wordStarts;
+    const uint32_t* frequencies;
+    const uint32_t* bucketStarts;
+    const uint32_t* entries;
+    const char32_t* pool;
+    uint32_t poolSize;
+    uint32_t entryCount;
+};
+
+#endif
@@ -0,0 +1,490 @@
+/**
+ * @file TextProcessing.cpp
+ * @brief Text extraction, tokenizing and formatting shared by mkindex and edahttpd
+ * @version 1.0
+ */
+
+#include "TextProcessing.h"
+
+#include <unicode/uchar.h>
+#include <unicode/ustring.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <regex>
+
+#include "Trace.h"
+
+using namespace std;
+
+/**
+ * @brief Compares html at position with a lowercase ASCII tag name
+ */
+static bool matchesIgnoreCase(const string& html, size_t position, const char* lowercase) {
+    for (; *lowercase; lowercase++, position++) {
+        if (position >= html.size() || tolower((unsigned char)html[position]) != *lowercase)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Finds a lowercase ASCII closing tag, ignoring case
+ */
+static size_t findIgnoreCase(const string& html, size_t position, const char* lowercase) {
+    for (position = html.find('<', position); position != string::npos;
+         position = html.find('<', position + 1)) {
+        if (matchesIgnoreCase(html, position, lowercase))
+            return position;
+    }
+    return string::npos;
+}
+
+string removeHTMLTags(const string& html) {
+    TRACE_SPAN("removeHTMLTags");
+    string result;
+    result.reserve(html.size() / 2);
+
+    // Starts as if preceded by a space, so leading whitespace is dropped
+    bool lastWasSpace = true;
+
+    for (size_t i = 0; i < html.size(); i++) {
+        unsigned char c = html[i];
+
+        if (c == '<') {
+            // Skips <script>...</script> and <style>...</style> with their content
+            const char* endTag = nullptr;
+            if (matchesIgnoreCase(html, i + 1, "script"))
+                endTag = "</script";
+            else if (matchesIgnoreCase(html, i + 1, "style"))
+                endTag = "</style";
+
+            size_t tagEnd = endTag ? findIgnoreCase(html, i, endTag) : i;
+            if (tagEnd == string::npos)
+                tagEnd = i;
+            tagEnd = html.find('>', tagEnd);
+            if (tagEnd == string::npos)
+                break;
+            i = tagEnd;
+
+            // Tags separate words
+            c = ' ';
+        }
+
+        // Reduces line breaks and multiple spaces
+        if (isspace(c)) {
+            if (!lastWasSpace) {
+                result += ' ';
+                lastWasSpace = true;
+            }
+        } else {
+            result += (char)c;
+            lastWasSpace = false;
+        }
+    }
+
+    // Trims trailing space
+    if (!result.empty() && result.back() == ' ')
+        result.pop_back();
+
+    return result;
+}
+
+/**
+ * @brief Generates a snippet from cleaned text content
+ *
+ * @param cleanText Already cleaned text (no HTML tags)
+ * @param maxWords Maximum number of words in snippet
+ * @return Snippet text with ellipsis if truncated
+ */
+string generateSnippetFromCleanText(const string& cleanText, int maxWords) {
+    TRACE_SPAN("generateSnippetFromCleanText");
+
+    // Finds where the first maxWords words end, without copying them
+    size_t position = 0;
+    size_t snippetEnd = 0;
+    int words = 0;
+
+    while (words < maxWords) {
+        size_t wordStart = cleanText.find_first_not_of(" \t\n\r", position);
+        if (wordStart == string::npos)
+            break;
+        position = cleanText.find_first_of(" \t\n\r", wordStart);
+        if (position == string::npos)
+            position = cleanText.size();
+        snippetEnd = position;
+        words++;
+    }
+
+    if (!words) {
+        return "";
+    }
+
+    size_t snippetStart = cleanText.find_first_not_of(" \t\n\r");
+    string snippet = cleanText.substr(snippetStart, snippetEnd - snippetStart);
+
+    // Add ellipsis if there are more words
+    if (cleanText.find_first_not_of(" \t\n\r", snippetEnd) != string::npos) {
+        snippet += "...";
+    }
+
+    return snippet;
+}
+
+size_t vocabulary(const string& cleanContent,
+                  std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t>& converter,
+                  set<string>& vocabSet,
+                  BigramCounts* bigramCounts) {
+    TRACE_SPAN("vocabulary");
+    string previous;
+    forEachWord(converter.from_bytes(cleanContent), [&](const u32string& word) {
+        string utf8Word = converter.to_bytes(word);
+        if (bigramCounts && !previous.empty())
+            (*bigramCounts)[previous + ' ' + utf8Word]++;
+        vocabSet.insert(utf8Word);
+        previous.swap(utf8Word);
+    });
+    return vocabSet.size();
+}
+
+//============================ URL / HTML ESCAPING ============================//
+
+// Bytes classified per SIMD step
+#if defined(__AVX2__)
+static const size_t ESCAPE_BLOCK = 32;
+#elif defined(__SSE2__) || defined(_M_X64)
+static const size_t ESCAPE_BLOCK = 16;
+#else
+static const size_t ESCAPE_BLOCK = 0;
+#endif
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+static inline unsigned firstSetBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static inline bool isUrlSafe(unsigned char c) {
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '-' ||
+           c == '_' || c == '.' || c == '~' || c == '/';
+}
+
+static inline bool isHtmlSpecial(unsigned char c) {
+    return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'';
+}
+
+#if defined(__AVX2__)
+
+/**
+ * @brief Bit i is set if byte i of the block must be percent-encoded
+ */
+static inline uint32_t urlUnsafeMask(const char* block) {
+    __m256i c = _mm256_loadu_si256((const __m256i*)block);
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+
+    // Signed compares: bytes >= 0x80 are negative and fall outside every range
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i punct = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')),
+                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'))),
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('.')),
+                                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('~'))),
+                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'))));
+
+    __m256i safe = _mm256_or_si256(_mm256_or_si256(digit, alpha), punct);
+    return ~(uint32_t)_mm256_movemask_epi8(safe);
+}
+
+/**
+ * @brief Bit i is set if byte i of the block is one of & < > " '
+ */
+static inline uint32_t htmlSpecialMask(const char* block) {
+    __m256i c = _mm256_loadu_si256((const __m256i*)block);
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('&')),
+                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('<'))),
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('>')),
+                                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('"'))),
+                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\''))));
+    return (uint32_t)_mm256_movemask_epi8(special);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+/**
+ * @brief Bit i is set if byte i of the block must be percent-encoded
+ */
+static inline uint32_t urlUnsafeMask(const char* block) {
+    __m128i c = _mm_loadu_si128((const __m128i*)block);
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+
+    // Signed compares: bytes >= 0x80 are negative and fall outside every range
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i punct =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')),
+                                  _mm_cmpeq_epi8(c, _mm_set1_epi8('_'))),
+                     _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('.')),
+                                               _mm_cmpeq_epi8(c, _mm_set1_epi8('~'))),
+                                  _mm_cmpeq_epi8(c, _mm_set1_epi8('/'))));
+
+    __m128i safe = _mm_or_si128(_mm_or_si128(digit, alpha), punct);
+    return ~(uint32_t)_mm_movemask_epi8(safe) & 0xFFFF;
+}
+
+/**
+ * @brief Bit i is set if byte i of the block is one of & < > " '
+ */
+static inline uint32_t htmlSpecialMask(const char* block) {
+    __m128i c = _mm_loadu_si128((const __m128i*)block);
+    __m128i special =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('&')),
+                                  _mm_cmpeq_epi8(c, _mm_set1_epi8('<'))),
+                     _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('>')),
+                                               _mm_cmpeq_epi8(c, _mm_set1_epi8('"'))),
+                                  _mm_cmpeq_epi8(c, _mm_set1_epi8('\''))));
+    return (uint32_t)_mm_movemask_epi8(special);
+}
+
+#else
+
+static inline uint32_t urlUnsafeMask(const char*) {
+    return 0;
+}
+
+static inline uint32_t htmlSpecialMask(const char*) {
+    return 0;
+}
+
+#endif
+
+/**
+ * @brief Copies runs of plain bytes in bulk and calls escape on the others
+ *
+ * Whole blocks are classified with one SIMD mask; the tail (and every byte
+ * on targets without SSE2) goes through the scalar test.
+ */
+template <typename BlockMask, typename IsSpecial, typename Escape>
+static void appendEscaped(
+    string& out, const string& str, BlockMask blockMask, IsSpecial isSpecial, Escape escape) {
+    const char* data = str.data();
+    size_t size = str.size();
+    size_t pending = 0;  // Start of the plain bytes not yet copied
+    size_t i = 0;
+
+    if (ESCAPE_BLOCK) {
+        while (i + ESCAPE_BLOCK <= size) {
+            uint32_t mask = blockMask(data + i);
+            if (!mask) {
+                i += ESCAPE_BLOCK;
+                continue;
+            }
+
+            size_t special = i + firstSetBit(mask);
+            out.append(data + pending, special - pending);
+            escape(out, data, size, special);
+            pending = i = special + 1;
+        }
+    }
+
+    for (; i < size; i++) {
+        if (isSpecial((unsigned char)data[i])) {
+            out.append(data + pending, i - pending);
+            escape(out, data, size, i);
+            pending = i + 1;
+        }
+    }
+
+    out.append(data + pending, size - pending);
+}
+
+/**
+ * @brief True if position starts a character reference such as &amp; or &#233;
+ */
+static bool isCharacterReference(const char* data, size_t size, size_t position) {
+    size_t end = min(size, position + 12);
+    size_t i = position + 1;
+    if (i < end && data[i] == '#')
+        i++;
+
+    size_t nameStart = i;
+    while (i < end && isalnum((unsigned char)data[i]))
+        i++;
+    return i > nameStart && i < end && data[i] == ';';
+}
+
+void appendUrlEncoded(string& out, const string& str) {
+    out.reserve(out.size() + str.size());
+
+    appendEscaped(
+        out,
+        str,
+        urlUnsafeMask,
+        [](unsigned char c) { return !isUrlSafe(c); },
+        [](string& out, const char* data, size_t, size_t position) {
+            unsigned char c = data[position];
+            char encoded[3] = {'%', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF]};
+            out.append(encoded, 3);
+        });
+}
+
+void appendHtmlEscaped(string& out, const string& str) {
+    out.reserve(out.size() + str.size());
+
+    appendEscaped(out,
+                  str,
+                  htmlSpecialMask,
+                  isHtmlSpecial,
+                  [](string& out, const char* data, size_t size, size_t position) {
+                      switch (data[position]) {
+                          case '&':
+                              // Text taken from HTML keeps its references; avoids &amp;amp;
+                              out += isCharacterReference(data, size, position) ? "&" : "&amp;";
+                              break;
+                          case '<':
+                              out += "&lt;";
+                              break;
+                          case '>':
+                              out += "&gt;";
+                              break;
+                          case '"':
+                              out += "&quot;";
+                              break;
+                          default:
+                              out += "&#39;";
+                              break;
+                      }
+                  });
+}
+
+/**
+ * @brief URL encodes a string (replaces spaces and special characters)
+ *
+ * @param str Input string
+ * @return URL-encoded string
+ */
+string urlEncode(const string& str) {
+    string encoded;
+    appendUrlEncoded(encoded, str);
+    return encoded;
+}
+
+void appendJsonEscaped(string& out, const string& str) {
+    out.reserve(out.size() + str.size());
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char escaped[6] = {'\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF]};
+            out.append(escaped, 6);
+        } else {
+            out += (char)c;
+        }
+    }
+}
+
+string htmlEscape(const string& str) {
+    string escaped;
+    appendHtmlEscaped(escaped, str);
+    return escaped;
+}
+
+/**
+ * @brief Generates a snippet from HTML file content
+ *
+ * @param filePath Path to the HTML file
+ * @param maxWords Maximum number of words in snippet
+ * @return Snippet text with ellipsis if truncated
+ */
+string generateSnippet(const string& filePath, int maxWords) {
+    ifstream file(filePath, ios::binary);
+    if (!file.is_open()) {
+        return "";
+    }
+
+    // Read entire file
+    string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    return generateSnippetFromCleanText(removeHTMLTags(content), maxWords);
+}
+
+/**
+ * @brief Converts filename to title case
+ *
+ * @param filename Input filename
+ * @return Cleaned and formatted title
+ */
+string cleanTitle(const string& filename) {
+    TRACE_SPAN("cleanTitle");
+    string result = filename;
+
+    // Replace underscores with spaces
+    replace(result.begin(), result.end(), '_', ' ');
+
+    // Remove parentheses and their content
+    regex parenRegex("\\([^)]*\\)");
+    result = regex_replace(result, parenRegex, "");
+
+    // Trim spaces
+    size_t start = result.find_first_not_of(" \t");
+    size_t end = result.find_last_not_of(" \t");
+
+    if (start != string::npos && end != string::npos) {
+        result = result.substr(start, end - start + 1);
+    }
+
+    // Capitalize first letter of each word (simple title case)
+    bool capitalizeNext = true;
+    for (size_t i = 0; i < result.length(); i++) {
+        if (capitalizeNext && isalpha(result[i])) {
+            result[i] = toupper(result[i]);
+            capitalizeNext = false;
+        } else if (result[i] == ' ') {
+            capitalizeNext = true;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Cleans URL for display (removes leading slash)
+ *
+ * @param url Input URL
+ * @return Cleaned URL
+ */
+string cleanUrl(const string& url) {
+    if (url.empty()) {
+        return url;
+    }
+
+    // Remove leading slash
+    if (url[0] == '/') {
+        return url.substr(1);
+    }
+
+    return url;
+}
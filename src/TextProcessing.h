@@ -0,0 +1,165 @@
+/**
+ * @file TextProcessing.h
+ * @brief Text extraction, tokenizing and formatting shared by mkindex and edahttpd
+ * @version 1.0
+ */
+
+#ifndef TEXTPROCESSING_H
+#define TEXTPROCESSING_H
+
+#include <unicode/uchar.h>
+
+#include <codecvt>
+#include <locale>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+// Shortest word kept in the vocabulary and the autocomplete Trie
+const size_t MIN_WORD_LENGTH = 5;
+
+/**
+ * @name forEachWord
+ * @brief Tokenizer shared by indexing and vocabulary loading
+ *
+ * Words are runs of alphabetic code points, lowercased; shorter words
+ * than minLength are skipped.
+ *
+ * @param text Text to tokenize (UTF-32)
+ * @param onWord Called with each word
+ * @param minLength Shortest word emitted
+ */
+template <typename Callback>
+void forEachWord(const std::u32string& text, Callback onWord, size_t minLength = MIN_WORD_LENGTH) {
+    std::u32string word;
+    word.reserve(20);
+
+    for (char32_t c : text) {
+        if (u_isalpha(c)) {
+            // Builds word character by character
+            word.push_back(u_tolower(c));
+        } else {
+            // Emits word once a non-word character is found
+            if (word.size() >= minLength)
+                onWord(word);
+            word.clear();
+        }
+    }
+
+    // Emits last word if applicable
+    if (word.size() >= minLength)
+        onWord(word);
+}
+
+/**
+ * @name removeHTMLTags
+ * @brief Extracts readable text from HTML in a single pass
+ *
+ * Tags become word separators, <script> and <style> blocks are dropped
+ * with their content (case-insensitive), whitespace is collapsed and trimmed.
+ *
+ * @param html Raw HTML content
+ * @return Plain text
+ */
+std::string removeHTMLTags(const std::string& html);
+
+/**
+ * @name generateSnippetFromCleanText
+ * @brief Generates a snippet from cleaned text content
+ * @param cleanText Already cleaned text (no HTML tags)
+ * @param maxWords Maximum number of words in snippet
+ * @return Snippet text with ellipsis if truncated
+ */
+std::string generateSnippetFromCleanText(const std::string& cleanText, int maxWords = 100);
+
+// Occurrences of "first second", for consecutive vocabulary words of a text
+typedef std::unordered_map<std::string, uint32_t> BigramCounts;
+
+/**
+ * @name vocabulary
+ * @brief Adds every lowercase word of 5+ letters to the vocabulary
+ * @param cleanContent Plain text (UTF-8)
+ * @param converter UTF-8 / UTF-32 converter
+ * @param vocabSet Vocabulary being built
+ * @param bigramCounts Optional, counts each pair of consecutive vocabulary words
+ * @return Vocabulary size
+ */
+size_t vocabulary(const std::string& cleanContent,
+                  std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t>& converter,
+                  std::set<std::string>& vocabSet,
+                  BigramCounts* bigramCounts = nullptr);
+
+/**
+ * @name appendUrlEncoded
+ * @brief Percent-encodes every byte except alphanumerics and - _ . ~ /
+ *
+ * Classifies 16 (SSE2) or 32 (AVX2) bytes per step and copies plain runs
+ * in bulk; falls back to a scalar loop on other targets.
+ *
+ * @param out Buffer the encoded string is appended to
+ * @param str Input string
+ */
+void appendUrlEncoded(std::string& out, const std::string& str);
+
+/**
+ * @name appendHtmlEscaped
+ * @brief Escapes & < > " ' for HTML text and attribute values
+ *
+ * Vectorized like appendUrlEncoded. An '&' that already starts a character
+ * reference (as in snippets taken from HTML) is kept as is.
+ *
+ * @param out Buffer the escaped string is appended to
+ * @param str Input string
+ */
+void appendHtmlEscaped(std::string& out, const std::string& str);
+
+/**
+ * @name appendJsonEscaped
+ * @brief Escapes a string for use inside a JSON string literal
+ * @param out Buffer the escaped string is appended to
+ * @param str Input string (UTF-8, copied through)
+ */
+void appendJsonEscaped(std::string& out, const std::string& str);
+
+/**
+ * @name urlEncode
+ * @brief URL encodes a string (replaces spaces and special characters)
+ * @param str Input string
+ * @return URL-encoded string
+ */
+std::string urlEncode(const std::string& str);
+
+/**
+ * @name htmlEscape
+ * @brief Returns str escaped as in appendHtmlEscaped
+ * @param str Input string
+ * @return Escaped string
+ */
+std::string htmlEscape(const std::string& str);
+
+/**
+ * @name generateSnippet
+ * @brief Generates a snippet from an HTML file, cleaned as in removeHTMLTags
+ * @param filePath Path to the HTML file
+ * @param maxWords Maximum number of words in snippet
+ * @return Snippet text with ellipsis if truncated
+ */
+std::string generateSnippet(const std::string& filePath, int maxWords = 30);
+
+/**
+ * @name cleanTitle
+ * @brief Converts filename to title case
+ * @param filename Input filename
+ * @return Cleaned and formatted title
+ */
+std::string cleanTitle(const std::string& filename);
+
+/**
+ * @name cleanUrl
+ * @brief Cleans URL for display (removes leading slash)
+ * @param url Input URL
+ * @return Cleaned URL
+ */
+std::string cleanUrl(const std::string& url);
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * @file Thumbnail.cpp
+ * @brief Downscaled JPEG thumbnails of the indexed images
+ * @version 1.0
+ */
+
+#include "Thumbnail.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#ifdef EDAOOGLE_THUMBNAILS
+#include <csetjmp>
+
+#include <jpeglib.h>
+#include <png.h>
+#endif
+
+using namespace std;
+
+bool thumbnailsSupported() {
+#ifdef EDAOOGLE_THUMBNAILS
+    return true;
+#else
+    return false;
+#endif
+}
+
+string thumbnailKey(const string& path) {
+    ifstream file(path, ios::binary);
+    if (file.fail())
+        return "";
+
+    // FNV-1a over the whole file
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    char buffer[65536];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        for (streamsize i = 0; i < file.gcount(); i++) {
+            hash ^= (unsigned char)buffer[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+    return key;
+}
+
+#ifdef EDAOOGLE_THUMBNAILS
+
+/**
+ * @brief Decoded RGB image, 3 bytes per pixel
+ */
+struct RgbImage {
+    int width = 0;
+    int height = 0;
+    vector<unsigned char> pixels;
+};
+
+/**
+ * @brief libjpeg error manager that returns instead of calling exit()
+ */
+struct JpegError {
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+};
+
+static void onJpegError(j_common_ptr info) {
+    longjmp(((JpegError*)info->err)->jump, 1);
+}
+
+/**
+ * @brief Fits width x height into a THUMBNAIL_SIZE box, keeping the aspect ratio
+ */
+static void fitThumbnail(int width, int height, int& fitWidth, int& fitHeight) {
+    if (width <= THUMBNAIL_SIZE && height <= THUMBNAIL_SIZE) {
+        fitWidth = width;
+        fitHeight = height;
+    } else if (width >= height) {
+        fitWidth = THUMBNAIL_SIZE;
+        fitHeight = max(1, (int)((int64_t)height * THUMBNAIL_SIZE / width));
+    } else {
+        fitHeight = THUMBNAIL_SIZE;
+        fitWidth = max(1, (int)((int64_t)width * THUMBNAIL_SIZE / height));
+    }
+}
+
+static bool decodePng(const string& path, RgbImage& image) {
+    png_image png = {};
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path.c_str()))
+        return false;
+
+    // Transparent pixels are composited onto the white page background
+    png.format = PNG_FORMAT_RGB;
+    png_color background = {255, 255, 255};
+
+    image.width = png.width;
+    image.height = png.height;
+    image.pixels.resize(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, &background, image.pixels.data(), 0, NULL)) {
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+static bool decodeJpeg(const string& path, RgbImage& image) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    jpeg_decompress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = onJpegError;
+
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        fclose(file);
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, file);
+    jpeg_read_header(&info, TRUE);
+
+    // DCT scaling decodes at 1/2, 1/4 or 1/8 size for free while staying
+    // larger than the thumbnail
+    int fitWidth, fitHeight;
+    fitThumbnail(info.image_width, info.image_height, fitWidth, fitHeight);
+
+    info.scale_num = 1;
+    info.scale_denom = 1;
+    while (info.scale_denom < 8) {
+        int denominator = (int)info.scale_denom * 2;
+        if ((int)info.image_width / denominator < fitWidth ||
+            (int)info.image_height / denominator < fitHeight)
+            break;
+        info.scale_denom = denominator;
+    }
+
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+
+    image.width = info.output_width;
+    image.height = info.output_height;
+    image.pixels.resize((size_t)image.width * image.height * 3);
+
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = image.pixels.data() + (size_t)info.output_scanline * image.width * 3;
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Box filter: every output pixel averages the source pixels it covers
+ */
+static void downscale(const RgbImage& source, RgbImage& target) {
+    target.pixels.resize((size_t)target.width * target.height * 3);
+
+    for (int y = 0; y < target.height; y++) {
+        int y0 = (int)((int64_t)y * source.height / target.height);
+        int y1 = max(y0 + 1, (int)((int64_t)(y + 1) * source.height / target.height));
+
+        for (int x = 0; x < target.width; x++) {
+            int x0 = (int)((int64_t)x * source.width / target.width);
+            int x1 = max(x0 + 1, (int)((int64_t)(x + 1) * source.width / target.width));
+
+            uint32_t sum[3] = {0, 0, 0};
+            for (int sy = y0; sy < y1; sy++) {
+                const unsigned char* row = source.pixels.data() + ((size_t)sy * source.width) * 3;
+                for (int sx = x0; sx < x1; sx++) {
+                    sum[0] += row[sx * 3];
+                    sum[1] += row[sx * 3 + 1];
+                    sum[2] += row[sx * 3 + 2];
+                }
+            }
+
+            uint32_t count = (uint32_t)(y1 - y0) * (x1 - x0);
+            unsigned char* out = target.pixels.data() + ((size_t)y * target.width + x) * 3;
+            for (int c = 0; c < 3; c++)
+                out[c] = (unsigned char)((sum[c] + count / 2) / count);
+        }
+    }
+}
+
+static bool encodeJpeg(const RgbImage& image, const string& path) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    jpeg_compress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = onJpegError;
+
+    if (setjmp(error.jump)) {
+        jpeg_destroy_compress(&info);
+        fclose(file);
+        return false;
+    }
+
+    jpeg_create_compress(&info);
+    jpeg_stdio_dest(&info, file);
+
+    info.image_width = image.width;
+    info.image_height = image.height;
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, THUMBNAIL_QUALITY, TRUE);
+    jpeg_start_compress(&info, TRUE);
+
+    while (info.next_scanline < info.image_height) {
+        JSAMPROW row = (JSAMPROW)image.pixels.data() + (size_t)info.next_scanline * image.width * 3;
+        jpeg_write_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+    return fclose(file) == 0;
+}
+
+#endif
+
+bool generateThumbnail(const string& source, const string& destination) {
+#ifdef EDAOOGLE_THUMBNAILS
+    RgbImage image;
+    string extension = filesystem::path(source).extension().string();
+    for (char& c : extension)
+        c = (char)tolower((unsigned char)c);
+
+    bool decoded = extension == ".png" ? decodePng(source, image) : decodeJpeg(source, image);
+    if (!decoded || image.width <= 0 || image.height <= 0)
+        return false;
+
+    RgbImage thumbnail;
+    fitThumbnail(image.width, image.height, thumbnail.width, thumbnail.height);
+    downscale(image, thumbnail);
+
+    // Writes under a per-thread temporary name so the final file appears atomically
+    string temporary =
+        destination + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    if (!encodeJpeg(thumbnail, temporary)) {
+        remove(temporary.c_str());
+        return false;
+    }
+
+    error_code renameError;
+    filesystem::rename(temporary, destination, renameError);
+    return !renameError;
+#else
+    (void)source;
+    (void)destination;
+    return false;
+#endif
+}
@@ -0,0 +1,49 @@
+/**
+ * @file Thumbnail.h
+ * @brief Downscaled JPEG thumbnails of the indexed images
+ * @version 1.0
+ */
+
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include <string>
+
+// Largest side of a thumbnail, in pixels
+const int THUMBNAIL_SIZE = 320;
+
+// JPEG quality of the thumbnails
+const int THUMBNAIL_QUALITY = 80;
+
+/**
+ * @name thumbnailsSupported
+ * @brief Whether mkindex was built with the PNG and JPEG libraries
+ */
+bool thumbnailsSupported();
+
+/**
+ * @name thumbnailKey
+ * @brief Hashes the image content (FNV-1a, 64 bits) into a file name
+ *
+ * Identical images share a thumbnail and an edited image gets a new one,
+ * so existing thumbnails never need to be invalidated.
+ *
+ * @param path Image file
+ * @return Hex key, or an empty string if the file cannot be read
+ */
+std::string thumbnailKey(const std::string& path);
+
+/**
+ * @name generateThumbnail
+ * @brief Decodes a PNG/JPEG, box-filters it to THUMBNAIL_SIZE and writes a JPEG
+ *
+ * The file is written under a temporary name and renamed, so concurrent
+ * writers and readers never see a partial thumbnail.
+ *
+ * @param source Original image
+ * @param destination Thumbnail file
+ * @return True if the thumbnail was written
+ */
+bool generateThumbnail(const std::string& source, const std::string& destination);
+
+#endif
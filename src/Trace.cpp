@@ -0,0 +1,145 @@
+/**
+ * @file Trace.cpp
+ * @brief Lightweight sampled request tracing (Chrome trace-event export)
+ * @version 1.0
+ */
+
+#include "Trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace Trace {
+    // Events kept per thread before the oldest ones are overwritten
+    static const size_t RING_CAPACITY = 8192;
+
+    struct Event {
+        const char* name;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    struct RingBuffer {
+        mutex lock;
+        uint32_t threadId;
+        uint64_t written = 0;
+        vector<Event> events = vector<Event>(RING_CAPACITY);
+    };
+
+    static atomic<uint32_t> sampleThreshold(0);
+    static atomic<uint32_t> nextThreadId(1);
+    static mutex registryLock;
+    static vector<shared_ptr<RingBuffer>> registry;
+    static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+    static thread_local bool sampled = false;
+    static thread_local uint32_t randomState = 0;
+    static thread_local shared_ptr<RingBuffer> threadBuffer;
+
+    static uint64_t now() {
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - epoch)
+            .count();
+    }
+
+    static uint32_t nextRandom() {
+        // xorshift32, seeded per thread
+        if (!randomState)
+            randomState = 2463534242u ^ (nextThreadId.load() * 2654435761u);
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return randomState;
+    }
+
+    static void record(const char* name, uint64_t start, uint64_t end) {
+        if (!threadBuffer) {
+            threadBuffer = make_shared<RingBuffer>();
+            threadBuffer->threadId = nextThreadId++;
+
+            lock_guard<mutex> guard(registryLock);
+            registry.push_back(threadBuffer);
+        }
+
+        lock_guard<mutex> guard(threadBuffer->lock);
+        Event& event = threadBuffer->events[threadBuffer->written % RING_CAPACITY];
+        event.name = name;
+        event.start = start;
+        event.duration = end - start;
+        threadBuffer->written++;
+    }
+
+    void setSampleRate(double rate) {
+        if (rate <= 0.0)
+            sampleThreshold = 0;
+        else if (rate >= 1.0)
+            sampleThreshold = UINT32_MAX;
+        else
+            sampleThreshold = (uint32_t)(rate * UINT32_MAX);
+    }
+
+    double getSampleRate() {
+        return (double)sampleThreshold.load() / UINT32_MAX;
+    }
+
+    string dumpJson() {
+        vector<shared_ptr<RingBuffer>> buffers;
+        {
+            lock_guard<mutex> guard(registryLock);
+            buffers = registry;
+        }
+
+        string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+
+        for (auto& buffer : buffers) {
+            lock_guard<mutex> guard(buffer->lock);
+
+            uint64_t count = min<uint64_t>(buffer->written, RING_CAPACITY);
+            for (uint64_t i = buffer->written - count; i < buffer->written; i++) {
+                const Event& event = buffer->events[i % RING_CAPACITY];
+
+                if (!first)
+                    json += ",";
+                first = false;
+
+                json += "{\"name\":\"";
+                json += event.name;
+                json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + to_string(buffer->threadId) +
+                        ",\"ts\":" + to_string(event.start) +
+                        ",\"dur\":" + to_string(event.duration) + "}";
+            }
+        }
+        json += "]}";
+
+        return json;
+    }
+
+    Request::Request(const char* name) : name(name), start(0), wasSampled(sampled) {
+        uint32_t threshold = sampleThreshold.load(memory_order_relaxed);
+        sampled = threshold && (threshold == UINT32_MAX || nextRandom() < threshold);
+        if (sampled)
+            start = now();
+    }
+
+    Request::~Request() {
+        if (sampled)
+            record(name, start, now());
+        sampled = wasSampled;
+    }
+
+    Span::Span(const char* name) : name(name), start(0) {
+        if (sampled)
+            start = now() + 1;
+    }
+
+    Span::~Span() {
+        // start is offset by one so that zero means "not sampled"
+        if (start && sampled)
+            record(name, start - 1, now());
+    }
+}  // namespace Trace
@@ -0,0 +1,63 @@
+/**
+ * @file Trace.h
+ * @brief Lightweight sampled request tracing (Chrome trace-event export)
+ * @version 1.0
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+namespace Trace {
+    /**
+     * @name setSampleRate
+     * @brief Sets the fraction of requests that record spans
+     * @param rate Value between 0 (disabled) and 1 (every request)
+     */
+    void setSampleRate(double rate);
+    double getSampleRate();
+
+    /**
+     * @name dumpJson
+     * @brief Exports every recorded span as Chrome trace_event JSON
+     * @return JSON document loadable in chrome://tracing or Perfetto
+     */
+    std::string dumpJson();
+
+    /**
+     * @class Request
+     * @brief Decides whether the current request on this thread is sampled
+     */
+    class Request {
+      public:
+        Request(const char* name);
+        ~Request();
+
+      private:
+        const char* name;
+        uint64_t start;
+        bool wasSampled;
+    };
+
+    /**
+     * @class Span
+     * @brief Records its lifetime into the thread's ring buffer if sampled
+     */
+    class Span {
+      public:
+        Span(const char* name);
+        ~Span();
+
+      private:
+        const char* name;
+        uint64_t start;
+    };
+}  // namespace Trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif
@@ -0,0 +1,530 @@
+/**
+ * @file benchmarks.cpp
+ * @brief Microbenchmarks for Trie and text processing
+ * @version 1.0
+ *
+ * Google-Benchmark style runner: each benchmark loops over
+ * state.keepRunning(), the iteration count grows until the run takes at
+ * least -mintime seconds, and time, allocations and allocated bytes are
+ * reported per operation.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <codecvt>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CommandLineParser.h"
+#include "LoudsTrie.h"
+#include "Phrases.h"
+#include "QueryCompiler.h"
+#include "SubstringIndex.h"
+#include "SymSpell.h"
+#include "TextProcessing.h"
+#include "trie.h"
+
+using namespace std;
+
+//=============== ALLOCATION COUNTING ===============//
+
+static atomic<uint64_t> allocationCount(0);
+static atomic<uint64_t> allocationBytes(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    if (void* pointer = malloc(size ? size : 1))
+        return pointer;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+//=============== RUNNER ===============//
+
+/**
+ * @class BenchmarkState
+ * @brief Iteration control and measurements for one benchmark run
+ */
+class BenchmarkState {
+  public:
+    BenchmarkState(uint64_t iterations) : iterations(iterations), remaining(iterations + 1) {
+    }
+
+    /**
+     * @name keepRunning
+     * @brief Loop condition; measurements start on the first call
+     * @return True while iterations remain
+     */
+    bool keepRunning() {
+        if (remaining == iterations + 1) {
+            startAllocations = allocationCount.load();
+            startBytes = allocationBytes.load();
+            startTime = chrono::steady_clock::now();
+        }
+        if (--remaining > 0)
+            return true;
+
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        allocations = allocationCount.load() - startAllocations;
+        bytes = allocationBytes.load() - startBytes;
+        return false;
+    }
+
+    uint64_t iterations;
+    uint64_t bytesProcessed = 0;
+    double elapsed = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+  private:
+    uint64_t remaining;
+    uint64_t startAllocations = 0;
+    uint64_t startBytes = 0;
+    chrono::steady_clock::time_point startTime;
+};
+
+struct Benchmark {
+    string name;
+    std::function<void(BenchmarkState&)> run;
+};
+
+// Keeps results observable so the optimizer cannot drop the work
+static volatile size_t benchmarkSink;
+
+static void runBenchmark(const Benchmark& benchmark, double minTime) {
+    uint64_t iterations = 1;
+
+    while (true) {
+        BenchmarkState state(iterations);
+        benchmark.run(state);
+
+        if (state.elapsed >= minTime || iterations >= 1000000000) {
+            double nsPerOp = state.elapsed * 1e9 / iterations;
+
+            cout << left << setw(40) << benchmark.name << right << fixed << setprecision(1)
+                 << setw(14) << nsPerOp << " ns" << setw(12) << iterations << setprecision(2)
+                 << setw(12) << (double)state.allocations / iterations << " allocs/op"
+                 << setprecision(1) << setw(14) << (double)state.bytes / iterations
+                 << " B/op";
+            if (state.bytesProcessed)
+                cout << setprecision(1) << setw(10)
+                     << state.bytesProcessed / state.elapsed / (1024 * 1024) << " MB/s";
+            cout << endl;
+            return;
+        }
+
+        // Aims for minTime based on the last run, growing at most 10x
+        double scale = state.elapsed > 0 ? minTime * 1.4 / state.elapsed : 10;
+        iterations = (uint64_t)(iterations * min(max(scale, 2.0), 10.0));
+    }
+}
+
+//=============== DATA SETS ===============//
+
+/**
+ * @brief Generates Spanish-like words: shared stems and shared endings
+ */
+static vector<string> generateVocabulary(size_t count) {
+    static const vector<string> syllables = {
+        "al", "go", "rit", "mo", "bus", "que", "da", "bi", "na", "ria", "or", "de", "na",
+        "mien", "to", "gra", "fo", "ár", "bol", "ta", "bla", "com", "ple", "ji", "dad",
+        "pro", "ra", "ma", "ción", "es", "truc", "tu", "ra", "ví", "ne", "lu", "ña", "ca"};
+    static const vector<string> endings = {
+        "", "", "ción", "mente", "amos", "ando", "idad", "ado", "es", "ería"};
+
+    mt19937 random(42);
+    uniform_int_distribution<size_t> syllablePicker(0, syllables.size() - 1);
+    uniform_int_distribution<size_t> endingPicker(0, endings.size() - 1);
+    uniform_int_distribution<int> lengthPicker(2, 5);
+
+    set<string> unique;
+    while (unique.size() < count) {
+        string word;
+        for (int i = lengthPicker(random); i > 0; i--)
+            word += syllables[syllablePicker(random)];
+        word += endings[endingPicker(random)];
+        if (word.size() >= 5)
+            unique.insert(word);
+    }
+
+    vector<string> words(unique.begin(), unique.end());
+    shuffle(words.begin(), words.end(), random);
+    return words;
+}
+
+/**
+ * @brief Generates an HTML page similar to the indexed wiki pages
+ */
+static string generateHtmlPage(const vector<string>& words, size_t paragraphs) {
+    mt19937 random(7);
+    uniform_int_distribution<size_t> wordPicker(0, words.size() - 1);
+
+    string html =
+        "<!DOCTYPE html>\n<html lang=\"es\">\n<head>\n<meta charset=\"UTF-8\">\n"
+        "<title>Algoritmo de ordenamiento</title>\n"
+        "<style>\nbody { font-family: sans-serif; }\n.box { margin: 0 auto; }\n</style>\n"
+        "<script>\nfunction toggle(id) { var e = document.getElementById(id); }\n</script>\n"
+        "</head>\n<body>\n<div class=\"box\">\n";
+
+    for (size_t i = 0; i < paragraphs; i++) {
+        html += "<h2 id=\"s" + to_string(i) + "\">" + words[wordPicker(random)] + "</h2>\n<p>";
+        for (int j = 0; j < 80; j++) {
+            if (j % 17 == 5)
+                html += "<a href=\"/wiki/" + words[wordPicker(random)] + ".html\">";
+            html += words[wordPicker(random)];
+            html += (j % 17 == 5) ? "</a>" : "";
+            html += (j % 12 == 11) ? ".\n" : " ";
+        }
+        html += "</p>\n";
+    }
+    html += "</div>\n</body>\n</html>\n";
+
+    return html;
+}
+
+int main(int argc, const char* argv[]) {
+    CommandLineParser parser(argc, argv);
+
+    if (parser.hasOption("-help")) {
+        cout << "-filter (text): optional, runs benchmarks whose name contains text." << endl
+             << "-mintime (seconds): optional, minimum time per benchmark. Defaults to 0.5."
+             << endl
+             << "-words (number): optional, vocabulary size. Defaults to 100000." << endl
+             << "-path (insertYourFolderRelativePath): optional, uses real .html files and"
+             << endl
+             << "image names from a www folder." << endl;
+        return 1;
+    }
+
+    string filter = parser.getOption("-filter");
+    double minTime = parser.hasOption("-mintime") ? stod(parser.getOption("-mintime")) : 0.5;
+    size_t wordCount = parser.hasOption("-words") ? stoul(parser.getOption("-words")) : 100000;
+
+    // Builds data sets
+    wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
+    vector<string> words = generateVocabulary(wordCount);
+    vector<u32string> words32;
+    for (const string& word : words)
+        words32.push_back(converter.from_bytes(word));
+
+    vector<string> pages;
+    vector<string> imageNames;
+    if (parser.hasOption("-path")) {
+        error_code error;
+        for (const auto& entry :
+             filesystem::recursive_directory_iterator(parser.getOption("-path"), error)) {
+            string extension = entry.path().extension().string();
+            if (extension == ".html") {
+                ifstream file(entry.path(), ios::binary);
+                pages.emplace_back(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+            } else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg") {
+                imageNames.push_back(entry.path().filename().string());
+            }
+        }
+    }
+    if (pages.empty()) {
+        pages.push_back(generateHtmlPage(words, 8));
+        pages.push_back(generateHtmlPage(words, 40));
+    }
+    if (imageNames.empty()) {
+        imageNames = {"que es un arbol AVL.png",
+                      "cual es la complejidad del algoritmo quicksort en el peor caso.png",
+                      "Merge_sort_animation(2).jpg",
+                      "que algoritmo de ordenamiento tiene complejidad O(n^2).png"};
+    }
+
+    vector<string> cleanPages;
+    for (const string& page : pages)
+        cleanPages.push_back(removeHTMLTags(page));
+
+    Trie fullTrie;
+    for (const u32string& word : words32)
+        fullTrie.insert(word);
+
+    vector<string> sortedWords(words.begin(), words.end());
+    sort(sortedWords.begin(), sortedWords.end());
+    sortedWords.erase(unique(sortedWords.begin(), sortedWords.end()), sortedWords.end());
+    LoudsTrie loudsTrie;
+    loudsTrie.build(sortedWords);
+    SubstringIndex substringIndex;
+    substringIndex.build(sortedWords);
+
+    PhraseMiner phraseMiner;
+    for (const string& cleanPage : cleanPages)
+        phraseMiner.addText(cleanPage);
+    PhraseCompleter phraseCompleter;
+    phraseCompleter.build(phraseMiner.getPhrases(1));
+
+    // The spelling index is read from a file, as edahttpd maps it
+    SymSpellBuilder spellingBuilder;
+    for (size_t i = 0; i < sortedWords.size(); i++)
+        spellingBuilder.add(sortedWords[i], (uint32_t)(1 + i % 100));
+    string spellingFile = (filesystem::temp_directory_path() / "benchmarks.symspell").string();
+    spellingBuilder.save(spellingFile);
+    SymSpell spelling;
+    spelling.load(spellingFile);
+    filesystem::remove(spellingFile);
+
+    // Words with one substituted and one transposed letter
+    vector<string> misspellings;
+    for (size_t i = 0; i < 1000; i++) {
+        u32string word = converter.from_bytes(sortedWords[(i * 7919) % sortedWords.size()]);
+        if (word.size() > 3) {
+            word[1] = word[1] == U'x' ? U'y' : U'x';
+            swap(word[2], word[3]);
+        }
+        misspellings.push_back(converter.to_bytes(word));
+    }
+
+    vector<string> prefixes;
+    for (size_t i = 0; i < 1000; i++) {
+        const u32string& word = words32[i % words32.size()];
+        prefixes.push_back(converter.to_bytes(word.substr(0, 1 + i % 4)));
+    }
+    vector<u32string> prefixes32;
+    for (const string& prefix : prefixes)
+        prefixes32.push_back(converter.from_bytes(prefix));
+
+    // Benchmarks
+    vector<Benchmark> benchmarks = {
+        {"Trie::insert/utf8",
+         [&](BenchmarkState& state) {
+             Trie trie;
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink = trie.insert(words[i++ % words.size()]);
+         }},
+        {"Trie::insert/u32",
+         [&](BenchmarkState& state) {
+             Trie trie;
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink = trie.insert(words32[i++ % words32.size()]);
+         }},
+        {"Trie::build/serial",
+         [&](BenchmarkState& state) {
+             while (state.keepRunning()) {
+                 Trie trie;
+                 for (const auto& word : words32)
+                     trie.insert(word);
+             }
+         }},
+        {"Trie::build/parallel",
+         [&](BenchmarkState& state) {
+             while (state.keepRunning()) {
+                 Trie trie;
+                 benchmarkSink = trie.insertParallel(words32);
+             }
+         }},
+        {"Trie::startsWith",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink = fullTrie.startsWith(prefixes[i++ % prefixes.size()]);
+         }},
+        {"Trie::collectSuggestions/10",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink = fullTrie.collectSuggestions(prefixes[i++ % prefixes.size()], 10);
+         }},
+        {"Trie::collectSuggestions/10/shortest",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             vector<u32string> suggestions;
+             while (state.keepRunning()) {
+                 suggestions.clear();
+                 benchmarkSink = fullTrie.collectSuggestions(prefixes32[i++ % prefixes32.size()],
+                                                             10,
+                                                             suggestions,
+                                                             SUGGEST_SHORTEST_FIRST);
+             }
+         }},
+        {"LoudsTrie::startsWith",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink = loudsTrie.startsWith(prefixes[i++ % prefixes.size()]);
+         }},
+        {"LoudsTrie::collectSuggestions/10",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             vector<string> suggestions;
+             while (state.keepRunning()) {
+                 suggestions.clear();
+                 benchmarkSink = loudsTrie.collectSuggestions(
+                     prefixes[i++ % prefixes.size()], 10, suggestions);
+             }
+         }},
+        {"SubstringIndex::build",
+         [&](BenchmarkState& state) {
+             while (state.keepRunning()) {
+                 SubstringIndex index;
+                 benchmarkSink = index.build(sortedWords);
+             }
+         }},
+        {"SubstringIndex::collectInfixSuggestions/10",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             vector<string> suggestions;
+             while (state.keepRunning()) {
+                 suggestions.clear();
+                 benchmarkSink = substringIndex.collectInfixSuggestions(
+                     prefixes[i++ % prefixes.size()], 10, suggestions);
+             }
+         }},
+        {"removeHTMLTags",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning()) {
+                 const string& page = pages[i++ % pages.size()];
+                 benchmarkSink = removeHTMLTags(page).size();
+                 state.bytesProcessed += page.size();
+             }
+         }},
+        {"generateSnippetFromCleanText/60",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink =
+                     generateSnippetFromCleanText(cleanPages[i++ % cleanPages.size()], 60).size();
+         }},
+        {"vocabulary",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             set<string> vocabSet;
+             while (state.keepRunning()) {
+                 const string& cleanPage = cleanPages[i++ % cleanPages.size()];
+                 vocabSet.clear();
+                 benchmarkSink = vocabulary(cleanPage, converter, vocabSet);
+                 state.bytesProcessed += cleanPage.size();
+             }
+         }},
+        {"PhraseMiner::addText",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning()) {
+                 const string& cleanPage = cleanPages[i++ % cleanPages.size()];
+                 phraseMiner.addText(cleanPage);
+                 state.bytesProcessed += cleanPage.size();
+             }
+         }},
+        {"PhraseCompleter::collectSuggestions/4",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             vector<string> suggestions;
+             while (state.keepRunning()) {
+                 suggestions.clear();
+                 benchmarkSink = phraseCompleter.collectSuggestions(
+                     prefixes[i++ % prefixes.size()], 4, suggestions);
+             }
+         }},
+        {"QueryCompiler::compile",
+         [&](BenchmarkState& state) {
+             // No index attached: tokenizing, folding and the Trie expansion bound
+             QueryCompiler queryCompiler;
+             auto countExpansions = [&](const u32string& prefix, size_t limit) {
+                 vector<u32string> words;
+                 return fullTrie.collectSuggestions(prefix, limit + 1, words, SUGGEST_SYMBOL_ORDER);
+             };
+             size_t i = 0;
+             string match;
+             while (state.keepRunning()) {
+                 const string& name = imageNames[i++ % imageNames.size()];
+                 queryCompiler.compile(name, match, countExpansions);
+                 benchmarkSink = match.size();
+                 state.bytesProcessed += name.size();
+             }
+         }},
+        {"SymSpell::lookup",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             string correction;
+             uint32_t distance;
+             while (state.keepRunning())
+                 benchmarkSink = spelling.lookup(
+                     misspellings[i++ % misspellings.size()], correction, distance);
+         }},
+        {"cleanTitle",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning())
+                 benchmarkSink = cleanTitle(imageNames[i++ % imageNames.size()]).size();
+         }},
+        {"urlEncode",
+         [&](BenchmarkState& state) {
+             size_t i = 0;
+             while (state.keepRunning()) {
+                 const string& name = imageNames[i++ % imageNames.size()];
+                 benchmarkSink = urlEncode("/special/" + name).size();
+                 state.bytesProcessed += name.size() + 9;
+             }
+         }},
+        {"appendHtmlEscaped/page",
+         [&](BenchmarkState& state) {
+             string out;
+             size_t i = 0;
+             while (state.keepRunning()) {
+                 const string& cleanPage = cleanPages[i++ % cleanPages.size()];
+                 out.clear();
+                 appendHtmlEscaped(out, cleanPage);
+                 benchmarkSink = out.size();
+                 state.bytesProcessed += cleanPage.size();
+             }
+         }},
+    };
+
+    cout << words.size() << " words, " << pages.size() << " pages, " << imageNames.size()
+         << " image names" << endl
+         << left << setw(40) << "Benchmark" << right << setw(17) << "Time" << setw(12)
+         << "Iterations" << setw(22) << "Allocations" << setw(19) << "Bytes" << endl
+         << string(110, '-') << endl;
+
+    for (const Benchmark& benchmark : benchmarks) {
+        if (benchmark.name.find(filter) != string::npos)
+            runBenchmark(benchmark, minTime);
+    }
+
+    return 0;
+}
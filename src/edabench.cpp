@@ -0,0 +1,532 @@
+/**
+ * @file edabench.cpp
+ * @brief HTTP load generator and latency benchmark for edahttpd
+ * @version 1.0
+ *
+ * Replays a query mix over keep-alive connections at a fixed rate. Latency is
+ * measured from the time each request was scheduled to be sent, so a stalled
+ * server is not hidden by the client waiting on it (coordinated omission).
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandLineParser.h"
+#include "QueryLog.h"
+
+using namespace std;
+
+static const char* routeNames[QUERYLOG_ROUTES] = {"search", "predict", "lucky", "image", "other"};
+
+/**
+ * @brief A request scheduled at a fixed offset from the start of the run
+ */
+struct BenchRequest {
+    uint64_t offset;  // microseconds
+    QueryLogRoute route;
+    string url;
+};
+
+/**
+ * @brief Per-thread results, merged once the run ends
+ */
+struct BenchResults {
+    vector<uint32_t> latency[QUERYLOG_ROUTES];  // scheduled start to last byte (microseconds)
+    vector<uint32_t> service[QUERYLOG_ROUTES];  // actual send to last byte (microseconds)
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @name helpMessage
+ * @brief Sends a message through terminal for guidance
+ */
+bool helpMessage() {
+    cout << "/==========================================================================/" << endl
+         << "Parameters:" << endl
+         << "-host (address): optional, server address. Defaults to 127.0.0.1." << endl
+         << "-port (number): optional, server port. Defaults to 8000." << endl
+         << "-threads (number): optional, client threads, one keep-alive connection each."
+         << endl
+         << "Defaults to 4." << endl
+         << "-rate (requests per second): optional, total request rate. Defaults to 100." << endl
+         << "-duration (seconds): optional, length of the run. Defaults to 10." << endl
+         << "-mix (search,predict,lucky,image): optional, relative weights." << endl
+         << "Defaults to 60,30,5,5. A predict counts as one whole typed word." << endl
+         << "-queries (file): optional, one query per line. Defaults to a built-in list." << endl
+         << "-path (insertYourFolderRelativePath): optional, www folder used to find images."
+         << endl
+         << "-replay (file): optional, replays an edahttpd -querylog instead of the mix." << endl
+         << "-speed (factor): optional, replay speed-up. Defaults to 1 (real time)." << endl
+         << endl;
+
+    cout << "example for Linux:" << endl
+         << "./edabench -rate 500 -duration 30 -mix 50,50,0,0 -path ../www/" << endl
+         << "./edabench -replay queries.log -speed 4 -threads 16" << endl
+         << "/==========================================================================/" << endl;
+
+    return 1;
+}
+
+/**
+ * @brief URL encodes a query argument
+ *
+ * @param str Input string
+ * @return URL-encoded string
+ */
+static string urlEncodeArgument(const string& str) {
+    static const char* hexDigits = "0123456789ABCDEF";
+    string encoded;
+
+    for (unsigned char c : str) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
+            encoded += c;
+        } else {
+            encoded += '%';
+            encoded += hexDigits[c >> 4];
+            encoded += hexDigits[c & 15];
+        }
+    }
+
+    return encoded;
+}
+
+/**
+ * @brief Builds the synthetic schedule for one thread
+ *
+ * Requests are spaced evenly at the thread's share of the total rate. A predict
+ * entry expands into one request per typed character of the query.
+ */
+static vector<BenchRequest> buildSchedule(const vector<string>& queries,
+                                          const vector<string>& images,
+                                          const vector<double>& mix,
+                                          double rate,
+                                          double duration,
+                                          unsigned seed) {
+    vector<BenchRequest> schedule;
+    mt19937 random(seed);
+    discrete_distribution<int> routePicker(mix.begin(), mix.end());
+    uniform_int_distribution<size_t> queryPicker(0, queries.size() - 1);
+
+    double interval = 1e6 / rate;
+    size_t total = (size_t)(rate * duration);
+
+    while (schedule.size() < total) {
+        QueryLogRoute route = (QueryLogRoute)routePicker(random);
+        const string& query = queries[queryPicker(random)];
+
+        if (route == QUERYLOG_SEARCH) {
+            schedule.push_back({0, route, "/search?q=" + urlEncodeArgument(query)});
+        } else if (route == QUERYLOG_PREDICT) {
+            // Predict-as-you-type: one request per UTF-8 code point typed
+            for (size_t i = 1; i <= query.size() && schedule.size() < total; i++) {
+                if (i < query.size() && ((unsigned char)query[i] & 0xC0) == 0x80)
+                    continue;
+                schedule.push_back(
+                    {0, route, "/predict?q=" + urlEncodeArgument(query.substr(0, i))});
+            }
+        } else if (route == QUERYLOG_LUCKY) {
+            schedule.push_back({0, route, "/lucky"});
+        } else if (!images.empty()) {
+            uniform_int_distribution<size_t> imagePicker(0, images.size() - 1);
+            schedule.push_back({0, route, urlEncodeArgument(images[imagePicker(random)])});
+        }
+    }
+
+    for (size_t i = 0; i < schedule.size(); i++)
+        schedule[i].offset = (uint64_t)(i * interval);
+
+    return schedule;
+}
+
+/**
+ * @brief Builds replay schedules from a query log
+ *
+ * Requests keep their recorded spacing divided by the speed-up, and are
+ * dealt round-robin over the threads.
+ */
+static vector<vector<BenchRequest>> buildReplaySchedules(const vector<QueryLogEntry>& entries,
+                                                         double speed,
+                                                         int threads) {
+    vector<vector<BenchRequest>> schedules(threads);
+    if (entries.empty())
+        return schedules;
+
+    uint64_t firstTimestamp = entries.front().timestamp;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const QueryLogEntry& entry = entries[i];
+        string url;
+
+        if (entry.route == QUERYLOG_SEARCH)
+            url = "/search?q=" + urlEncodeArgument(entry.query);
+        else if (entry.route == QUERYLOG_PREDICT)
+            url = "/predict?q=" + urlEncodeArgument(entry.query);
+        else if (entry.route == QUERYLOG_LUCKY)
+            url = "/lucky";
+        else
+            url = urlEncodeArgument(entry.query);
+
+        uint64_t offset = (uint64_t)((entry.timestamp - firstTimestamp) / speed);
+        schedules[i % threads].push_back({offset, entry.route, url});
+    }
+
+    return schedules;
+}
+
+/**
+ * @brief Minimal keep-alive HTTP/1.1 client connection
+ */
+class BenchConnection {
+  public:
+    BenchConnection(const string& host, int port) : host(host), port(port), socketFd(-1) {
+    }
+    ~BenchConnection() {
+        disconnect();
+    }
+
+    /**
+     * @name get
+     * @brief Sends a GET request and reads the whole response
+     * @param url The URL
+     * @param bytes Incremented with the response size
+     * @return True if a complete response was received
+     */
+    bool get(const string& url, uint64_t& bytes) {
+        // Retries once on a fresh connection if the server closed the old one
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (socketFd < 0 && !connectToServer())
+                return false;
+
+            string request = "GET " + url + " HTTP/1.1\r\nHost: " + host +
+                             "\r\nConnection: keep-alive\r\n\r\n";
+            if (sendAll(request) && readResponse(bytes))
+                return true;
+
+            disconnect();
+        }
+        return false;
+    }
+
+  private:
+    string host;
+    int port;
+    int socketFd;
+    string buffer;
+
+    bool connectToServer() {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses;
+        if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &addresses) != 0)
+            return false;
+
+        for (addrinfo* address = addresses; address; address = address->ai_next) {
+            socketFd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (socketFd < 0)
+                continue;
+            if (connect(socketFd, address->ai_addr, address->ai_addrlen) == 0)
+                break;
+            close(socketFd);
+            socketFd = -1;
+        }
+        freeaddrinfo(addresses);
+
+        if (socketFd < 0)
+            return false;
+
+        int noDelay = 1;
+        setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        buffer.clear();
+        return true;
+    }
+
+    void disconnect() {
+        if (socketFd >= 0)
+            close(socketFd);
+        socketFd = -1;
+    }
+
+    bool sendAll(const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t result = send(socketFd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (result <= 0)
+                return false;
+            sent += result;
+        }
+        return true;
+    }
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t result = recv(socketFd, chunk, sizeof(chunk), 0);
+        if (result <= 0)
+            return false;
+        buffer.append(chunk, result);
+        return true;
+    }
+
+    bool readResponse(uint64_t& bytes) {
+        // Reads headers
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == string::npos) {
+            if (!fill())
+                return false;
+        }
+
+        string headers = buffer.substr(0, headerEnd);
+        transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+        buffer.erase(0, headerEnd + 4);
+
+        bool keepAlive = headers.find("connection: close") == string::npos;
+        size_t lengthPos = headers.find("content-length:");
+
+        if (lengthPos != string::npos) {
+            size_t contentLength = stoul(headers.substr(lengthPos + 15));
+            while (buffer.size() < contentLength) {
+                if (!fill())
+                    return false;
+            }
+            bytes += headerEnd + 4 + contentLength;
+            buffer.erase(0, contentLength);
+        } else if (headers.find("transfer-encoding: chunked") != string::npos) {
+            bytes += headerEnd + 4;
+            while (true) {
+                size_t lineEnd;
+                while ((lineEnd = buffer.find("\r\n")) == string::npos) {
+                    if (!fill())
+                        return false;
+                }
+                size_t chunkSize = stoul(buffer.substr(0, lineEnd), nullptr, 16);
+                while (buffer.size() < lineEnd + 2 + chunkSize + 2) {
+                    if (!fill())
+                        return false;
+                }
+                buffer.erase(0, lineEnd + 2 + chunkSize + 2);
+                bytes += chunkSize;
+                if (chunkSize == 0)
+                    break;
+            }
+        } else {
+            // Body delimited by connection close
+            while (fill())
+                ;
+            bytes += headerEnd + 4 + buffer.size();
+            buffer.clear();
+            keepAlive = false;
+        }
+
+        if (!keepAlive)
+            disconnect();
+        return true;
+    }
+};
+
+/**
+ * @brief Runs one thread's schedule over a single keep-alive connection
+ */
+static void runSchedule(const string& host,
+                        int port,
+                        const vector<BenchRequest>& schedule,
+                        chrono::steady_clock::time_point start,
+                        BenchResults& results) {
+    BenchConnection connection(host, port);
+
+    for (const BenchRequest& request : schedule) {
+        auto scheduled = start + chrono::microseconds(request.offset);
+        this_thread::sleep_until(scheduled);
+
+        auto sent = chrono::steady_clock::now();
+        bool ok = connection.get(request.url, results.bytes);
+        auto done = chrono::steady_clock::now();
+
+        if (!ok) {
+            results.errors++;
+            continue;
+        }
+
+        results.latency[request.route].push_back(
+            (uint32_t)chrono::duration_cast<chrono::microseconds>(done - scheduled).count());
+        results.service[request.route].push_back(
+            (uint32_t)chrono::duration_cast<chrono::microseconds>(done - sent).count());
+    }
+}
+
+/**
+ * @brief Prints latency percentiles of a sorted sample
+ */
+static void printPercentiles(const string& label, vector<uint32_t>& samples) {
+    if (samples.empty())
+        return;
+
+    sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t index = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[index] / 1000.0;
+    };
+
+    cout << "  " << left << setw(18) << label << right << fixed << setprecision(3)
+         << " p50 " << setw(9) << percentile(50) << " p90 " << setw(9) << percentile(90)
+         << " p99 " << setw(9) << percentile(99) << " p99.9 " << setw(9) << percentile(99.9)
+         << " max " << setw(9) << samples.back() / 1000.0 << " ms" << endl;
+}
+
+int main(int argc, const char* argv[]) {
+    CommandLineParser parser(argc, argv);
+
+    if (parser.hasOption("-help"))
+        return helpMessage();
+
+    // Configuration
+    string host = parser.hasOption("-host") ? parser.getOption("-host") : "127.0.0.1";
+    int port = parser.hasOption("-port") ? stoi(parser.getOption("-port")) : 8000;
+    int threads = parser.hasOption("-threads") ? stoi(parser.getOption("-threads")) : 4;
+    double rate = parser.hasOption("-rate") ? stod(parser.getOption("-rate")) : 100;
+    double duration = parser.hasOption("-duration") ? stod(parser.getOption("-duration")) : 10;
+
+    if (threads < 1 || rate <= 0 || duration <= 0) {
+        cout << "error: threads, rate and duration must be positive!" << endl;
+        return helpMessage();
+    }
+
+    vector<double> mix = {60, 30, 5, 5};
+    if (parser.hasOption("-mix")) {
+        stringstream mixStream(parser.getOption("-mix"));
+        string weight;
+        for (size_t i = 0; i < mix.size(); i++) {
+            mix[i] = getline(mixStream, weight, ',') ? stod(weight) : 0;
+        }
+    }
+
+    // Builds one schedule per thread, from a log or from the synthetic mix
+    vector<vector<BenchRequest>> schedules;
+
+    if (parser.hasOption("-replay")) {
+        double speed = parser.hasOption("-speed") ? stod(parser.getOption("-speed")) : 1;
+        if (speed <= 0) {
+            cout << "error: speed must be positive!" << endl;
+            return helpMessage();
+        }
+
+        vector<QueryLogEntry> entries;
+        if (!QueryLog::read(parser.getOption("-replay"), entries))
+            return 1;
+
+        schedules = buildReplaySchedules(entries, speed, threads);
+        if (!entries.empty()) {
+            duration = (entries.back().timestamp - entries.front().timestamp) / 1e6 / speed;
+            rate = duration > 0 ? entries.size() / duration : entries.size();
+        }
+        cout << "Replaying " << entries.size() << " requests at " << speed << "x" << endl;
+    }
+
+    // Loads queries
+    vector<string> queries;
+    if (parser.hasOption("-queries")) {
+        ifstream queryFile(parser.getOption("-queries"));
+        string line;
+        while (getline(queryFile, line)) {
+            if (!line.empty())
+                queries.push_back(line);
+        }
+    }
+    if (queries.empty()) {
+        queries = {"algoritmo",   "busqueda",  "binaria",     "ordenamiento", "grafo",
+                   "quicksort",   "arbol",     "tabla hash",  "complejidad",  "programacion",
+                   "dinamica",    "floodfill", "radix sort",  "merge sort",   "interpolacion",
+                   "estructura",  "datos",     "recorrido",   "trie",         "multithreading"};
+    }
+
+    // Finds images to request
+    vector<string> images;
+    if (parser.hasOption("-path")) {
+        filesystem::path specialPath = filesystem::path(parser.getOption("-path")) / "special";
+        error_code error;
+        for (const auto& entry : filesystem::directory_iterator(specialPath, error)) {
+            string extension = entry.path().extension().string();
+            if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+                images.push_back("/special/" + entry.path().filename().string());
+        }
+    }
+    if (images.empty())
+        mix[QUERYLOG_IMAGE] = 0;
+
+    for (int i = 0; schedules.empty() && i < threads; i++)
+        schedules.push_back(buildSchedule(queries, images, mix, rate / threads, duration, i + 1));
+
+    cout << "Running " << duration << " s at " << rate << " req/s over " << threads
+         << " connections to " << host << ":" << port << "..." << endl;
+
+    // Runs benchmark
+    vector<BenchResults> results(threads);
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now() + chrono::milliseconds(100);
+
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(
+            runSchedule, cref(host), port, cref(schedules[i]), start, ref(results[i]));
+    for (auto& worker : workers)
+        worker.join();
+
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Merges and reports results
+    BenchResults total;
+    size_t completed = 0;
+    for (auto& result : results) {
+        total.errors += result.errors;
+        total.bytes += result.bytes;
+        for (int route = 0; route < QUERYLOG_ROUTES; route++) {
+            total.latency[route].insert(total.latency[route].end(),
+                                        result.latency[route].begin(),
+                                        result.latency[route].end());
+            total.service[route].insert(total.service[route].end(),
+                                        result.service[route].begin(),
+                                        result.service[route].end());
+            completed += result.latency[route].size();
+        }
+    }
+
+    cout << "Completed: " << completed << " requests, " << total.errors << " errors in "
+         << fixed << setprecision(2) << elapsed << " s" << endl
+         << "Throughput: " << completed / elapsed << " req/s, "
+         << total.bytes / elapsed / (1024 * 1024) << " MiB/s" << endl;
+
+    vector<uint32_t> allLatency, allService;
+    for (int route = 0; route < QUERYLOG_ROUTES; route++) {
+        allLatency.insert(
+            allLatency.end(), total.latency[route].begin(), total.latency[route].end());
+        allService.insert(
+            allService.end(), total.service[route].begin(), total.service[route].end());
+    }
+
+    cout << "Latency (corrected for coordinated omission):" << endl;
+    printPercentiles("all", allLatency);
+    for (int route = 0; route < QUERYLOG_ROUTES; route++)
+        printPercentiles(routeNames[route], total.latency[route]);
+
+    cout << "Service time (send to last byte):" << endl;
+    printPercentiles("all", allService);
+
+    return total.errors ? 1 : 0;
+}
@@ -9,11 +9,15 @@
 
 #include <microhttpd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
 
 #include "CommandLineParser.h"
 #include "HttpRequestHandler.h"
 #include "HttpServer.h"
+#include "Trace.h"
 
 using namespace std;
 
@@ -26,6 +30,29 @@ bool printHelp() {
          << "specifies port to run the server on. Defaults to 8000." << endl
          << "-path (insertYourFolderRelativePath): mandatory," << endl
          << "specifies relative path to the www folder." << endl
+         << "-admin (no argument): optional," << endl
+         << "enables the /admin/ endpoints (/admin/trace, /admin/stats)." << endl
+         << "-tracerate (0 to 1): optional," << endl
+         << "fraction of requests recorded for /admin/trace. Defaults to 0." << endl
+         << "-querylog (file): optional," << endl
+         << "records every request to a binary log that edabench -replay can reproduce."
+         << endl
+         << "-autocomplete (trie / dawg / louds / concurrent): optional," << endl
+         << "structure /predict completes from. dawg loads the automaton written by" << endl
+         << "mkindex instead of building a Trie, louds builds a succinct read-only" << endl
+         << "trie, concurrent keeps adding the words mkindex -watch indexes." << endl
+         << "Defaults to trie." << endl
+         << "-infix (no argument): optional," << endl
+         << "/predict also suggests words containing the query (\"sort\" finds" << endl
+         << "\"quicksort\"), after the prefix matches. Builds a suffix array at startup." << endl
+         << "-threads (number): optional," << endl
+         << "request threads. Defaults to 1." << endl
+         << "-autocorrect (no argument): optional," << endl
+         << "searches without results are rerun with the spelling correction" << endl
+         << "mkindex wrote; otherwise it is only offered as \"Quizás quisiste decir\"." << endl
+         << "-searchtimeout (milliseconds): optional," << endl
+         << "time a search may spend ranking; slower ones list their first matches" << endl
+         << "unranked. 0 disables the limit. Defaults to 1000." << endl
          << endl;
 
     cout << "example for Linux:" << endl
@@ -72,10 +99,40 @@ int main(int argc, const char* argv[]) {
         return printHelp();
     }
 
-    // Start server
-    HttpServer server(port);
+    // Autocomplete structure
+    AutocompleteMode autocompleteMode = AUTOCOMPLETE_TRIE;
+    if (parser.getOption("-autocomplete") == "dawg")
+        autocompleteMode = AUTOCOMPLETE_DAWG;
+    else if (parser.getOption("-autocomplete") == "louds")
+        autocompleteMode = AUTOCOMPLETE_LOUDS;
+    else if (parser.getOption("-autocomplete") == "concurrent")
+        autocompleteMode = AUTOCOMPLETE_CONCURRENT;
+
+    unsigned threadCount = 1;
+    if (parser.hasOption("-threads"))
+        threadCount = max(1, stoi(parser.getOption("-threads")));
+
+    // Sets up request tracing before the vocabulary load, so startup is traced too
+    if (parser.hasOption("-tracerate"))
+        Trace::setSampleRate(stod(parser.getOption("-tracerate")));
 
-    HttpRequestHandler edaOogleHttpRequestHandler(wwwPath, imageMode);
+    // Opens query log (outlives the server, which may still be logging)
+    unique_ptr<QueryLog> queryLog;
+    if (parser.hasOption("-querylog"))
+        queryLog.reset(new QueryLog(parser.getOption("-querylog")));
+
+    // Start server
+    HttpServer server(port, threadCount);
+
+    HttpRequestHandler edaOogleHttpRequestHandler(
+        wwwPath, imageMode, autocompleteMode, parser.hasOption("-infix"));
+    edaOogleHttpRequestHandler.setAdminEnabled(parser.hasOption("-admin"));
+    edaOogleHttpRequestHandler.setAutocorrect(parser.hasOption("-autocorrect"));
+    if (parser.hasOption("-searchtimeout"))
+        edaOogleHttpRequestHandler.setSearchTimeout(
+            chrono::milliseconds(max(0, stoi(parser.getOption("-searchtimeout")))));
+    if (queryLog && queryLog->isOpen())
+        edaOogleHttpRequestHandler.setQueryLog(queryLog.get());
     server.setHttpRequestHandler(&edaOogleHttpRequestHandler);
 
     if (server.isRunning()) {
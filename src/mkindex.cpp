@@ -11,15 +11,34 @@
 #include <unicode/uchar.h>
 #include <unicode/ustring.h>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <codecvt>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <set>
-#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "CommandLineParser.h"
+#include "Dawg.h"
+#include "ImageInfo.h"
+#include "Phrases.h"
+#include "SearchIndex.h"
+#include "SymSpell.h"
+#include "TextProcessing.h"
+#include "Thumbnail.h"
 
 using namespace std;
 
@@ -38,6 +57,13 @@ bool helpMessage() {
          << "specifies whether to skip or not the vocabulary generation for the database." << endl
          << "-path (insertYourFolderRelativePath): mandatory," << endl
          << "specifies relative path for files to be indexed." << endl
+         << "-watch (no argument): optional, Linux only," << endl
+         << "keeps running after indexing and upserts files as they change." << endl
+         << "-debounce (milliseconds): optional," << endl
+         << "quiet time before a batch of changes is indexed. Defaults to 500." << endl
+         << "-thumbs (folder / none): optional, image mode only," << endl
+         << "where thumbnails are written. Defaults to a thumbs folder next to -path." << endl
+         << "It must be under the web root, the folder above -path, to be served." << endl
          << endl;
 
     cout << "example for Linux:" << endl
@@ -61,135 +87,164 @@ static int onDatabaseEntry(void* userdata, int argc, char** argv, char** azColNa
     return 0;
 }
 
-string removeHTMLTags(const string& html) {
-    string result;
-    string normalized;
-
-    result.reserve(html.size());
-
-    bool insideTag = false;
-    bool lastWasSpace = false;
-
-    for (size_t i = 0; i < html.size(); i++) {
-        if (html[i] == '<') {
-            insideTag = true;
-
-            // Detects and skips <script>...</script>
-            if (i + 7 <= html.size() && html.substr(i, 7) == "<script") {
-                // Looks for </script>
-                size_t scriptEnd = html.find("</script>", i);
-                if (scriptEnd != string::npos) {
-                    i = scriptEnd + 8;  // Skips ahead of </script>
-                    insideTag = false;
-                    continue;
-                }
-            }
-
-            // Detects and skips <style>...</style>
-            if (i + 6 <= html.size() && html.substr(i, 6) == "<style") {
-                // Buscar </style>
-                size_t styleEnd = html.find("</style>", i);
-                if (styleEnd != string::npos) {
-                    i = styleEnd + 7;  // Skips ahead of </style>
-                    insideTag = false;
-                    continue;
-                }
-            }
+/**
+ * @brief One row of the search index
+ */
+struct IndexEntry {
+    string path;
+    string title;
+    string content;
+    string snippet;
+    // Image index only
+    ImageInfo image;
+    string thumbnail;
+};
 
-        } else if (html[i] == '>') {
-            insideTag = false;
-        } else if (!insideTag) {
-            result += html[i];
-        }
-    }
+/**
+ * @brief Kind of table created by setupDatabase
+ */
+enum TableKind { PAGE_TABLE, IMAGE_TABLE, VOCABULARY_TABLE };
 
-    // Reduces line breaks and multiple spaces
-    for (unsigned char c : result) {
-        if (isspace(c)) {
-            if (!lastWasSpace) {
-                normalized += ' ';
-                lastWasSpace = true;
-            }
-        } else {
-            normalized += c;
-            lastWasSpace = false;
-        }
-    }
+/**
+ * @brief Builds the insert statement of an index table
+ *
+ * The image index also stores the header metadata read by readImageInfo.
+ */
+string indexInsertSQL(const char* tableName, bool imageMode) {
+    if (imageMode)
+        return string("INSERT INTO ") + tableName +
+               " (path, title, content, snippet, width, height, bytes, format, thumbnail)"
+               " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    return string("INSERT INTO ") + tableName +
+           " (path, title, content, snippet) VALUES (?, ?, ?, ?);";
+}
 
-    return normalized;
+bool isImageFile(const filesystem::path& file) {
+    string extension = file.extension().string();
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" ||
+           extension == ".PNG" || extension == ".JPG" || extension == ".JPEG";
 }
 
 /**
- * @brief Generates a snippet from cleaned text content
+ * @brief Reads an HTML file and extracts its title, text and snippet
  *
- * @param cleanText Already cleaned text (no HTML tags)
- * @param maxWords Maximum number of words in snippet
- * @return Snippet text with ellipsis if truncated
+ * @param file The HTML file
+ * @param entry The index row
+ * @return true File was read
+ * @return false File could not be opened
  */
-string generateSnippetFromCleanText(const string& cleanText, int maxWords = 100) {
-    if (cleanText.empty()) {
-        return "";
+bool extractHtmlEntry(const filesystem::path& file, IndexEntry& entry) {
+    // Reads file content
+    ifstream fileStream(file);
+    if (fileStream.fail()) {
+        return false;
     }
 
-    // Extract first N words
-    istringstream iss(cleanText);
-    string word;
-    vector<string> words;
+    string htmlContent((istreambuf_iterator<char>(fileStream)), istreambuf_iterator<char>());
+    fileStream.close();
 
-    while (iss >> word && words.size() < maxWords) {
-        words.push_back(word);
-    }
+    // Extract title
+    entry.title = "No Title";
+    size_t titleStart = htmlContent.find("<title>");
+    size_t titleEnd = htmlContent.find("</title>");
 
-    if (words.empty()) {
-        return "";
+    if (titleStart != string::npos && titleEnd != string::npos && titleEnd > titleStart) {
+        entry.title = htmlContent.substr(titleStart + 7, titleEnd - (titleStart + 7));
     }
 
-    // Join words
-    string snippet;
-    for (size_t i = 0; i < words.size(); i++) {
-        snippet += words[i];
-        if (i < words.size() - 1) {
-            snippet += " ";
-        }
-    }
+    // Parse HTML content to plain text
+    entry.content = removeHTMLTags(htmlContent);
 
-    // Add ellipsis if there are more words
-    bool hasMore = false;
-    if (iss >> word) {
-        hasMore = true;
-    }
+    // Generate snippet from clean content (first 60 words)
+    entry.snippet = generateSnippetFromCleanText(entry.content, 60);
 
-    if (hasMore || words.size() == maxWords) {
-        snippet += "...";
-    }
+    // Sets relative path
+    entry.path = "/wiki/" + file.filename().string();
 
-    return snippet;
+    return true;
 }
 
-size_t vocabulary(const string& cleanContent,
-                  std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t>& converter,
-                  set<string>& vocabSet) {
-    u32string convertedString = converter.from_bytes(cleanContent);
-    u32string word;
-    word.reserve(20);
-
-    for (UChar32 c : convertedString) {
-        if (u_isalpha(c)) {
-            // Builds word character by character
-            word.push_back(u_tolower(c));
-        } else if (word.size() >= 5) {
-            // Inserts word into vocabulary once a non-word character is found
-            vocabSet.insert(converter.to_bytes(word));
-            word.clear();
-        } else
-            word.clear();
+// URL path of the thumbnail folder under the web root, e.g. "/thumbs" (set in main)
+static string thumbnailUrl;
+
+/**
+ * @brief Builds the index row of an image from its filename and header
+ *
+ * Also writes the thumbnail, named by content hash, unless one with that
+ * name already exists. Safe to call from several threads.
+ *
+ * @param file The image file
+ * @param entry The index row
+ * @param thumbnailFolder Thumbnail directory, empty to skip thumbnails
+ */
+void extractImageEntry(const filesystem::path& file,
+                       IndexEntry& entry,
+                       const filesystem::path& thumbnailFolder) {
+    // Removes the extension, uses filename as title and content
+    string filename = file.stem().string();
+    entry.title = filename;
+    entry.content = filename;
+
+    // Generate snippet for images (just the filename)
+    entry.snippet = "Image: " + filename;
+
+    // Sets relative path
+    entry.path = "/special/" + file.filename().string();
+
+    // Reads dimensions from the PNG/JPEG header, without decoding pixels
+    if (!readImageInfo(file.string(), entry.image))
+        cout << "  Unknown image header: " << file.filename().string() << endl;
+
+    if (thumbnailFolder.empty() || !thumbnailsSupported())
+        return;
+
+    string key = thumbnailKey(file.string());
+    if (key.empty())
+        return;
+
+    filesystem::path thumbnailFile = thumbnailFolder / (key + ".jpg");
+    error_code error;
+    if (filesystem::exists(thumbnailFile, error) ||
+        generateThumbnail(file.string(), thumbnailFile.string())) {
+        entry.thumbnail = thumbnailUrl + "/" + thumbnailFile.filename().string();
+    } else {
+        cout << "  Thumbnail failed: " << file.filename().string() << endl;
     }
-    // Adds last word if applicable
-    if (word.size() >= 5) {
-        vocabSet.insert(converter.to_bytes(word));
-        word.clear();
+}
+
+/**
+ * @brief Inserts an index row with the prepared insert statement
+ *
+ * @return true Row inserted
+ * @return false Insert failed
+ */
+bool insertEntry(sqlite3* database, sqlite3_stmt* stmt, const IndexEntry& entry) {
+    // Bind values to the prepared statement
+    sqlite3_bind_text(stmt, 1, entry.path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, entry.title.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, entry.content.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, entry.snippet.c_str(), -1, SQLITE_TRANSIENT);
+
+    // Image metadata, only present in the image index statement
+    if (sqlite3_bind_parameter_count(stmt) == 9) {
+        sqlite3_bind_int64(stmt, 5, entry.image.width);
+        sqlite3_bind_int64(stmt, 6, entry.image.height);
+        sqlite3_bind_int64(stmt, 7, entry.image.bytes);
+        sqlite3_bind_text(stmt, 8, entry.image.format.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 9, entry.thumbnail.c_str(), -1, SQLITE_TRANSIENT);
     }
-    return vocabSet.size();
+
+    // Executes statement
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!success) {
+        cout << "  Error inserting: " << sqlite3_errmsg(database) << endl;
+    }
+
+    // Resets for next iteration
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    return success;
 }
 
 bool setupDatabase(const char* databaseFile,
@@ -197,7 +252,7 @@ bool setupDatabase(const char* databaseFile,
                    const char* tableName,
                    char*& databaseErrorMessage,
                    bool append,
-                   bool vocabulary,
+                   TableKind tableKind,
                    sqlite3_stmt*& stmt) {
     cout << "Starting Indexing..." << endl;
 
@@ -265,13 +320,27 @@ bool setupDatabase(const char* databaseFile,
 
     string createTableSQL;
 
-    if (!vocabulary) {
+    if (tableKind == PAGE_TABLE) {
+        createTableSQL = string("CREATE VIRTUAL TABLE IF NOT EXISTS ") + tableName +
+                         " USING fts5("
+                         "path UNINDEXED,"
+                         "title,"
+                         "content,"
+                         "snippet UNINDEXED,"
+                         "detail = none,"
+                         "tokenize = 'unicode61 remove_diacritics 2');";
+    } else if (tableKind == IMAGE_TABLE) {
         createTableSQL = string("CREATE VIRTUAL TABLE IF NOT EXISTS ") + tableName +
                          " USING fts5("
                          "path UNINDEXED,"
                          "title,"
                          "content,"
                          "snippet UNINDEXED,"
+                         "width UNINDEXED,"
+                         "height UNINDEXED,"
+                         "bytes UNINDEXED,"
+                         "format UNINDEXED,"
+                         "thumbnail UNINDEXED,"
                          "detail = none,"
                          "tokenize = 'unicode61 remove_diacritics 2');";
     } else {
@@ -295,9 +364,8 @@ bool setupDatabase(const char* databaseFile,
     cout << "Preparing SQL statement..." << endl;
     string insertSQL;
 
-    if (!vocabulary) {
-        insertSQL = string("INSERT INTO ") + tableName +
-                    " (path, title, content, snippet) VALUES (?, ?, ?, ?);";
+    if (tableKind != VOCABULARY_TABLE) {
+        insertSQL = indexInsertSQL(tableName, tableKind == IMAGE_TABLE);
     } else {
         insertSQL = string("INSERT INTO ") + tableName + " (vocabulary) VALUES (?);";
     }
@@ -352,17 +420,24 @@ bool finalizeDatabase(sqlite3_stmt*& stmt,
 bool indexDatabase(const string& inputFolder,
                    const char* databaseFile,
                    set<string>& vocabSet,
+                   BigramCounts& bigramCounts,
+                   PhraseMiner& phraseMiner,
                    bool append) {
     // Set up variables
     sqlite3* database;
     char* databaseErrorMessage = nullptr;
-    const char* tableName = "webpage_index";
+    const char* tableName = getIndexNames(false).indexTable;
     std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
     int processedFiles = 0;
     sqlite3_stmt* stmt;
 
-    if (setupDatabase(databaseFile, database, tableName, databaseErrorMessage, append, 0, stmt) !=
-        0) {
+    if (setupDatabase(databaseFile,
+                      database,
+                      tableName,
+                      databaseErrorMessage,
+                      append,
+                      PAGE_TABLE,
+                      stmt) != 0) {
         return 1;
     }
 
@@ -374,54 +449,20 @@ bool indexDatabase(const string& inputFolder,
         if (entry.is_regular_file() && entry.path().extension() == ".html") {
             cout << "Processing: " << entry.path().filename().string() << endl;
 
-            // Reads file content
-            ifstream fileStream(entry.path());
-            if (fileStream.fail()) {
+            IndexEntry indexEntry;
+            if (!extractHtmlEntry(entry.path(), indexEntry)) {
                 cout << "  Error opening file, skipping..." << endl;
                 continue;
             }
 
-            string htmlContent((istreambuf_iterator<char>(fileStream)),
-                               istreambuf_iterator<char>());
-            fileStream.close();
-
-            // Extract title
-            string title = "No Title";
-            size_t titleStart = htmlContent.find("<title>");
-            size_t titleEnd = htmlContent.find("</title>");
-
-            if (titleStart != string::npos && titleEnd != string::npos && titleEnd > titleStart) {
-                title = htmlContent.substr(titleStart + 7, titleEnd - (titleStart + 7));
-            }
-
-            // Parse HTML content to plain text
-            string cleanContent = removeHTMLTags(htmlContent);
-
-            // Generate snippet from clean content (first 25 words)
-            string snippet = generateSnippetFromCleanText(cleanContent, 60);
-
-            // Sets relative path
-            string relativePath = "/wiki/" + entry.path().filename().string();
-
             // Generates vocabulary
-            cout << "  Successfully extracted vocabulary. "
-                 << "Vocabulary size: " << vocabulary(cleanContent, converter, vocabSet) << endl;
-            cout << "  Generated snippet: " << snippet.substr(0, 50) << "..." << endl;
-
-            // Bind values to the prepared statement
-            sqlite3_bind_text(stmt, 1, relativePath.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 3, cleanContent.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 4, snippet.c_str(), -1, SQLITE_TRANSIENT);
-
-            // Executes statement
-            if (sqlite3_step(stmt) != SQLITE_DONE) {
-                cout << "  Error inserting: " << sqlite3_errmsg(database) << endl;
-            }
+            cout << "  Successfully extracted vocabulary. " << "Vocabulary size: "
+                 << vocabulary(indexEntry.content, converter, vocabSet, &bigramCounts) << endl;
+            phraseMiner.addText(indexEntry.title);
+            phraseMiner.addText(indexEntry.content);
+            cout << "  Generated snippet: " << indexEntry.snippet.substr(0, 50) << "..." << endl;
 
-            // Resets for next iteration
-            sqlite3_reset(stmt);
-            sqlite3_clear_bindings(stmt);
+            insertEntry(database, stmt, indexEntry);
 
             processedFiles++;
         }
@@ -434,65 +475,76 @@ bool indexDatabase(const string& inputFolder,
 bool imageDatabase(const string& inputFolder,
                    const char* databaseFile,
                    set<string>& vocabSet,
-                   bool append) {
+                   BigramCounts& bigramCounts,
+                   PhraseMiner& phraseMiner,
+                   bool append,
+                   const filesystem::path& thumbnailFolder) {
     // Set up variables
     sqlite3* database;
     char* databaseErrorMessage = nullptr;
-    const char* tableName = "images_index";
+    const char* tableName = getIndexNames(true).indexTable;
     std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
     int processedFiles = 0;
     sqlite3_stmt* stmt;
 
-    if (setupDatabase(databaseFile, database, tableName, databaseErrorMessage, append, 0, stmt) !=
-        0) {
+    if (setupDatabase(databaseFile,
+                      database,
+                      tableName,
+                      databaseErrorMessage,
+                      append,
+                      IMAGE_TABLE,
+                      stmt) != 0) {
         return 1;
     }
 
     // Iterate through files in the specified folder
     cout << "Indexing image files from folder: " << inputFolder << endl;
 
-    for (const auto& entry : filesystem::recursive_directory_iterator(inputFolder)) {
-        if (!entry.is_regular_file())
+    vector<filesystem::path> files;
+    error_code error;
+    for (auto iterator = filesystem::recursive_directory_iterator(inputFolder);
+         iterator != filesystem::recursive_directory_iterator();
+         ++iterator) {
+        // Never indexes the thumbnails themselves
+        if (iterator->is_directory() && !thumbnailFolder.empty() &&
+            filesystem::equivalent(iterator->path(), thumbnailFolder, error)) {
+            iterator.disable_recursion_pending();
             continue;
-
-        string extension = entry.path().extension().string();
+        }
 
         // Filters only image files
-        if (extension != ".png" && extension != ".jpg" && extension != ".jpeg" &&
-            extension != ".PNG" && extension != ".JPG" && extension != ".JPEG")
-            continue;
+        if (iterator->is_regular_file() && isImageFile(iterator->path()))
+            files.push_back(iterator->path());
+    }
 
-        cout << "Processing: " << entry.path().filename().string() << endl;
+    // Header parsing and thumbnail generation run in parallel
+    vector<IndexEntry> entries(files.size());
+    atomic<size_t> nextFile(0);
+    unsigned threadCount = max(1U, thread::hardware_concurrency());
+    vector<thread> workers;
 
-        // Removes the extension, uses filename as title and content
-        string filename = entry.path().stem().string();
-        string title = filename;
-        string cleanContent = filename;
+    cout << "Extracting " << files.size() << " images with " << threadCount << " threads..."
+         << endl;
 
-        // Generate snippet for images (just the filename)
-        string snippet = "Image: " + filename;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back([&]() {
+            for (size_t index = nextFile++; index < files.size(); index = nextFile++)
+                extractImageEntry(files[index], entries[index], thumbnailFolder);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
 
-        // Sets relative path
-        string relativePath = "/special/" + entry.path().filename().string();
+    for (auto& indexEntry : entries) {
+        cout << "Processing: " << indexEntry.title << endl;
 
         // Generates vocabulary
-        cout << "  Successfully extracted vocabulary. "
-             << "Vocabulary size: " << vocabulary(cleanContent, converter, vocabSet) << endl;
-
-        // Bind values to the prepared statement
-        sqlite3_bind_text(stmt, 1, relativePath.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, cleanContent.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 4, snippet.c_str(), -1, SQLITE_TRANSIENT);
+        cout << "  Successfully extracted vocabulary. " << "Vocabulary size: "
+             << vocabulary(indexEntry.content, converter, vocabSet, &bigramCounts) << endl;
+        // Image titles are the content too, so they are counted once
+        phraseMiner.addText(indexEntry.content);
 
-        // Executes statement
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            cout << "  Error inserting: " << sqlite3_errmsg(database) << endl;
-        }
-
-        // Resets for next iteration
-        sqlite3_reset(stmt);
-        sqlite3_clear_bindings(stmt);
+        insertEntry(database, stmt, indexEntry);
 
         processedFiles++;
     }
@@ -510,8 +562,13 @@ bool vocabularyDatabase(const char* databaseFile,
     char* databaseErrorMessage = nullptr;
     sqlite3_stmt* stmt;
 
-    if (setupDatabase(databaseFile, database, tableName, databaseErrorMessage, append, 1, stmt) !=
-        0) {
+    if (setupDatabase(databaseFile,
+                      database,
+                      tableName,
+                      databaseErrorMessage,
+                      append,
+                      VOCABULARY_TABLE,
+                      stmt) != 0) {
         return 1;
     }
 
@@ -531,6 +588,640 @@ bool vocabularyDatabase(const char* databaseFile,
     return finalizeDatabase(stmt, database, databaseErrorMessage, databaseFile, -1, tableName);
 }
 
+/**
+ * @brief Writes the minimal vocabulary automaton loaded by edahttpd -autocomplete dawg
+ *
+ * When appending, the words already in the vocabulary database are merged
+ * in, since the automaton is always rebuilt whole.
+ */
+bool vocabularyAutomaton(const IndexNames& names, const set<string>& vocabSet, bool append) {
+    cout << "Building vocabulary automaton..." << endl;
+    set<string> mergedWords;
+    const set<string>* words = &vocabSet;
+
+    if (append) {
+        sqlite3* database;
+        if (sqlite3_open(names.vocabFile, &database) == SQLITE_OK) {
+            std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
+            mergedWords = vocabSet;
+            readVocabulary(database, names.vocabTable, [&](const u32string& word) {
+                mergedWords.insert(converter.to_bytes(word));
+            });
+            words = &mergedWords;
+        }
+        sqlite3_close(database);
+    }
+
+    // std::set iterates in byte order, as the builder requires
+    DawgBuilder builder;
+    for (const auto& word : *words)
+        builder.add(word);
+
+    if (!builder.save(names.dawgFile)) {
+        cout << "Error writing " << names.dawgFile << endl;
+        return 1;
+    }
+
+    cout << "Successfully wrote " << names.dawgFile << ": " << words->size() << " words, "
+         << builder.getStateCount() << " states" << endl;
+    return 0;
+}
+
+// Followers kept per word in the bigram table
+static const size_t BIGRAM_FOLLOWERS = 8;
+
+/**
+ * @brief Writes the most frequent followers of each word, read by /predict
+ *
+ * Only the top BIGRAM_FOLLOWERS followers of each word are kept. When
+ * appending, counts are added to the existing rows.
+ */
+bool bigramDatabase(const IndexNames& names, const BigramCounts& bigramCounts, bool append) {
+    cout << "Writing bigram table..." << endl;
+
+    // Groups followers by first word
+    map<string, vector<pair<uint32_t, string>>> followers;
+    for (const auto& bigram : bigramCounts) {
+        size_t space = bigram.first.find(' ');
+        followers[bigram.first.substr(0, space)].emplace_back(bigram.second,
+                                                               bigram.first.substr(space + 1));
+    }
+
+    sqlite3* database;
+    if (sqlite3_open(names.vocabFile, &database) != SQLITE_OK) {
+        cout << "Error opening " << names.vocabFile << ": " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    string sql;
+    if (!append) {
+        sql = string("DROP TABLE IF EXISTS ") + names.bigramTable + ";";
+        sqlite3_exec(database, sql.c_str(), NULL, 0, NULL);
+    }
+    sql = string("CREATE TABLE IF NOT EXISTS ") + names.bigramTable +
+          " (first TEXT NOT NULL, second TEXT NOT NULL, count INTEGER NOT NULL,"
+          " PRIMARY KEY (first, second)) WITHOUT ROWID;";
+    if (sqlite3_exec(database, sql.c_str(), NULL, 0, NULL) != SQLITE_OK) {
+        cout << "Error: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    sqlite3_stmt* stmt;
+    sql = string("INSERT INTO ") + names.bigramTable +
+          " (first, second, count) VALUES (?, ?, ?)"
+          " ON CONFLICT (first, second) DO UPDATE SET count = count + excluded.count;";
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cout << "Error preparing statement: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    sqlite3_exec(database, "BEGIN TRANSACTION;", NULL, 0, NULL);
+    size_t rows = 0;
+    for (auto& entry : followers) {
+        auto& seconds = entry.second;
+        size_t kept = min(seconds.size(), BIGRAM_FOLLOWERS);
+        partial_sort(
+            seconds.begin(), seconds.begin() + kept, seconds.end(), [](auto& a, auto& b) {
+                return a.first != b.first ? a.first > b.first : a.second < b.second;
+            });
+
+        for (size_t i = 0; i < kept; i++) {
+            sqlite3_bind_text(stmt, 1, entry.first.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, seconds[i].second.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 3, seconds[i].first);
+            if (sqlite3_step(stmt) != SQLITE_DONE)
+                cout << "  Error inserting: " << sqlite3_errmsg(database) << endl;
+            sqlite3_reset(stmt);
+            rows++;
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    if (sqlite3_exec(database, "COMMIT;", NULL, 0, NULL) != SQLITE_OK) {
+        cout << "Error committing transaction: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+    sqlite3_close(database);
+
+    cout << "Successfully wrote " << rows << " bigrams for " << followers.size() << " words"
+         << endl;
+    return 0;
+}
+
+// Occurrences for a mined phrase to be stored
+static const uint32_t MIN_PHRASE_COUNT = 2;
+
+/**
+ * @brief Writes the heaviest mined phrases, read by /predict
+ *
+ * Counts are Count-Min estimates, so they may slightly overcount. When
+ * appending, counts are added to the existing rows.
+ */
+bool phraseDatabase(const IndexNames& names, const PhraseMiner& phraseMiner, bool append) {
+    cout << "Writing phrase table..." << endl;
+
+    sqlite3* database;
+    if (sqlite3_open(names.vocabFile, &database) != SQLITE_OK) {
+        cout << "Error opening " << names.vocabFile << ": " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    string sql;
+    if (!append) {
+        sql = string("DROP TABLE IF EXISTS ") + names.phraseTable + ";";
+        sqlite3_exec(database, sql.c_str(), NULL, 0, NULL);
+    }
+    sql = string("CREATE TABLE IF NOT EXISTS ") + names.phraseTable +
+          " (phrase TEXT PRIMARY KEY, count INTEGER NOT NULL) WITHOUT ROWID;";
+    if (sqlite3_exec(database, sql.c_str(), NULL, 0, NULL) != SQLITE_OK) {
+        cout << "Error: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    sqlite3_stmt* stmt;
+    sql = string("INSERT INTO ") + names.phraseTable +
+          " (phrase, count) VALUES (?, ?)"
+          " ON CONFLICT (phrase) DO UPDATE SET count = count + excluded.count;";
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cout << "Error preparing statement: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    sqlite3_exec(database, "BEGIN TRANSACTION;", NULL, 0, NULL);
+    auto phrases = phraseMiner.getPhrases(MIN_PHRASE_COUNT);
+    for (const auto& phrase : phrases) {
+        sqlite3_bind_text(stmt, 1, phrase.first.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, phrase.second);
+        if (sqlite3_step(stmt) != SQLITE_DONE)
+            cout << "  Error inserting: " << sqlite3_errmsg(database) << endl;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (sqlite3_exec(database, "COMMIT;", NULL, 0, NULL) != SQLITE_OK) {
+        cout << "Error committing transaction: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+    sqlite3_close(database);
+
+    cout << "Successfully wrote " << phrases.size() << " phrases" << endl;
+    return 0;
+}
+
+// Shortest index term offered as a spelling correction
+static const size_t MIN_SPELLING_LENGTH = 3;
+
+/**
+ * @brief Writes the spelling correction index loaded by edahttpd
+ *
+ * Built from the terms of the full-text index itself, so corrections are
+ * always searchable; the number of documents containing each term breaks
+ * ties. Terms with digits are left out. The index is rebuilt whole, which
+ * covers appended documents too.
+ */
+bool spellingIndex(const IndexNames& names) {
+    cout << "Building spelling index..." << endl;
+
+    sqlite3* database;
+    if (sqlite3_open(names.indexFile, &database) != SQLITE_OK) {
+        cout << "Error opening " << names.indexFile << ": " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    string sql = string("CREATE VIRTUAL TABLE temp.spelling_terms USING fts5vocab(main, ") +
+                 names.indexTable + ", row);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_exec(database, sql.c_str(), NULL, 0, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(
+            database, "SELECT term, doc FROM temp.spelling_terms;", -1, &stmt, NULL) !=
+            SQLITE_OK) {
+        cout << "Error: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+
+    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
+    SymSpellBuilder builder;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* term = (const char*)sqlite3_column_text(stmt, 0);
+        if (!term)
+            continue;
+        u32string term32 = converter.from_bytes(term);
+        if (term32.size() < MIN_SPELLING_LENGTH ||
+            !all_of(term32.begin(), term32.end(), [](char32_t c) { return u_isalpha(c); }))
+            continue;
+        builder.add(term, (uint32_t)sqlite3_column_int64(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(database);
+
+    if (!builder.save(names.spellingFile)) {
+        cout << "Error writing " << names.spellingFile << endl;
+        return 1;
+    }
+
+    cout << "Successfully wrote " << names.spellingFile << ": " << builder.getWordCount()
+         << " terms" << endl;
+    return 0;
+}
+
+#ifdef __linux__
+/**
+ * @brief Watches a folder and every folder below it
+ */
+static void addWatches(int inotifyFd,
+                       const filesystem::path& folder,
+                       map<int, filesystem::path>& watches) {
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE;
+
+    int wd = inotify_add_watch(inotifyFd, folder.c_str(), mask);
+    if (wd >= 0)
+        watches[wd] = folder;
+
+    error_code error;
+    for (const auto& entry : filesystem::recursive_directory_iterator(folder, error)) {
+        if (entry.is_directory()) {
+            wd = inotify_add_watch(inotifyFd, entry.path().c_str(), mask);
+            if (wd >= 0)
+                watches[wd] = entry.path();
+        }
+    }
+}
+
+/**
+ * @brief True if the watcher indexes file (thumbnails are never indexed)
+ */
+static bool isWatchedFile(const filesystem::path& file,
+                          bool imageMode,
+                          const filesystem::path& thumbnailFolder) {
+    bool wanted = imageMode ? isImageFile(file) : file.extension() == ".html";
+    error_code error;
+    return wanted && !(imageMode && !thumbnailFolder.empty() &&
+                       filesystem::equivalent(file.parent_path(), thumbnailFolder, error));
+}
+
+/**
+ * @brief True if path is folder or lies beneath it
+ */
+static bool isWithin(const filesystem::path& path, const filesystem::path& folder) {
+    return mismatch(folder.begin(), folder.end(), path.begin(), path.end()).first == folder.end();
+}
+
+/**
+ * @brief Stops watching a folder that left the tree, and every folder below it
+ */
+static void removeWatches(int inotifyFd,
+                          const filesystem::path& folder,
+                          map<int, filesystem::path>& watches) {
+    for (auto watch = watches.begin(); watch != watches.end();) {
+        if (isWithin(watch->second, folder)) {
+            inotify_rm_watch(inotifyFd, watch->first);
+            watch = watches.erase(watch);
+        } else
+            watch++;
+    }
+}
+
+/**
+ * @brief Upserts a batch of changed files into the index and vocabulary
+ *
+ * Each file's old row is deleted by rowid and re-extracted if it still exists.
+ * Words not seen before are appended to the vocabulary as one new row.
+ */
+static bool indexBatch(sqlite3* database,
+                       sqlite3* vocabDatabase,
+                       const IndexNames& names,
+                       bool imageMode,
+                       const filesystem::path& thumbnailFolder,
+                       const set<filesystem::path>& changedFiles,
+                       map<filesystem::path, sqlite3_int64>& rowids,
+                       set<string>& knownWords) {
+    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
+    sqlite3_stmt* insertStmt;
+    sqlite3_stmt* deleteStmt;
+    set<string> batchWords;
+    int upserted = 0;
+    int removed = 0;
+
+    string insertSQL = indexInsertSQL(names.indexTable, imageMode);
+    string deleteSQL = string("DELETE FROM ") + names.indexTable + " WHERE rowid = ?;";
+
+    if (sqlite3_prepare_v2(database, insertSQL.c_str(), -1, &insertStmt, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(database, deleteSQL.c_str(), -1, &deleteStmt, NULL) != SQLITE_OK) {
+        cout << "Error preparing statement: " << sqlite3_errmsg(database) << endl;
+        return 1;
+    }
+
+    sqlite3_exec(database, "BEGIN TRANSACTION;", NULL, 0, NULL);
+
+    for (const auto& file : changedFiles) {
+        if (!isWatchedFile(file, imageMode, thumbnailFolder))
+            continue;
+
+        IndexEntry entry;
+        entry.path = (imageMode ? "/special/" : "/wiki/") + file.filename().string();
+
+        // Removes old row
+        error_code error;
+        auto rowid = rowids.find(file);
+        if (rowid != rowids.end()) {
+            sqlite3_bind_int64(deleteStmt, 1, rowid->second);
+            sqlite3_step(deleteStmt);
+            sqlite3_reset(deleteStmt);
+            rowids.erase(rowid);
+            removed++;
+        }
+
+        // Re-extracts the file if it still exists
+        if (!filesystem::is_regular_file(file, error))
+            continue;
+
+        if (imageMode)
+            extractImageEntry(file, entry, thumbnailFolder);
+        else if (!extractHtmlEntry(file, entry))
+            continue;
+
+        if (insertEntry(database, insertStmt, entry)) {
+            rowids[file] = sqlite3_last_insert_rowid(database);
+            vocabulary(entry.content, converter, batchWords);
+            upserted++;
+        }
+    }
+
+    sqlite3_finalize(insertStmt);
+    sqlite3_finalize(deleteStmt);
+
+    if (sqlite3_exec(database, "COMMIT;", NULL, 0, NULL) != SQLITE_OK) {
+        cout << "Error committing transaction: " << sqlite3_errmsg(database) << endl;
+        return 1;
+    }
+    cout << "Upserted " << upserted << " files (" << removed << " old rows removed)" << endl;
+
+    if (!vocabDatabase)
+        return 0;
+
+    // Appends only new words
+    string vocabString;
+    size_t newWords = 0;
+    for (const auto& word : batchWords) {
+        if (knownWords.insert(word).second) {
+            vocabString += word + " ";
+            newWords++;
+        }
+    }
+
+    if (newWords) {
+        sqlite3_stmt* vocabStmt;
+        string vocabSQL = string("INSERT INTO ") + names.vocabTable + " (vocabulary) VALUES (?);";
+
+        if (sqlite3_prepare_v2(vocabDatabase, vocabSQL.c_str(), -1, &vocabStmt, NULL) !=
+            SQLITE_OK) {
+            cout << "Error preparing statement: " << sqlite3_errmsg(vocabDatabase) << endl;
+            return 1;
+        }
+        sqlite3_bind_text(vocabStmt, 1, vocabString.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(vocabStmt) != SQLITE_DONE) {
+            cout << "  Error inserting: " << sqlite3_errmsg(vocabDatabase) << endl;
+        }
+        sqlite3_finalize(vocabStmt);
+        cout << "Added " << newWords << " new vocabulary words" << endl;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Keeps the index in sync with a folder using inotify
+ *
+ * Changes are collected until the folder is quiet for debounceMs (or 10x that
+ * under constant writes), then indexed in one small transaction. Stops when a
+ * key + enter is pressed.
+ */
+bool watchDatabase(const string& inputFolder,
+                   bool imageMode,
+                   const filesystem::path& thumbnailFolder,
+                   bool skipVocab,
+                   int debounceMs) {
+    IndexNames names = getIndexNames(imageMode);
+    sqlite3* database;
+    sqlite3* vocabDatabase = nullptr;
+
+    // Opens index, waiting for readers such as edahttpd when busy
+    if (sqlite3_open(names.indexFile, &database) != SQLITE_OK) {
+        cout << "Can't open database: " << sqlite3_errmsg(database) << endl;
+        return 1;
+    }
+    sqlite3_busy_timeout(database, 5000);
+    sqlite3_exec(database, "PRAGMA journal_mode = WAL;", NULL, 0, NULL);
+
+    // Maps served paths to rowids, to find the files on disk
+    map<string, sqlite3_int64> servedRowids;
+    sqlite3_stmt* stmt;
+    string selectSQL = string("SELECT rowid, path FROM ") + names.indexTable + ";";
+    if (sqlite3_prepare_v2(database, selectSQL.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cout << "Error: " << sqlite3_errmsg(database) << endl;
+        sqlite3_close(database);
+        return 1;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* path = (const char*)sqlite3_column_text(stmt, 1);
+        if (path)
+            servedRowids[path] = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    // Maps indexed files to rowids, so updates delete by rowid and a folder
+    // leaving the tree takes the files below it along
+    map<filesystem::path, sqlite3_int64> rowids;
+    error_code error;
+    for (const auto& entry : filesystem::recursive_directory_iterator(inputFolder, error)) {
+        if (!entry.is_regular_file() || !isWatchedFile(entry.path(), imageMode, thumbnailFolder))
+            continue;
+        string served = (imageMode ? "/special/" : "/wiki/") + entry.path().filename().string();
+        auto rowid = servedRowids.find(served);
+        if (rowid != servedRowids.end()) {
+            rowids[entry.path()] = rowid->second;
+            servedRowids.erase(rowid);
+        }
+    }
+
+    // Rows whose file went away while nobody was watching
+    if (!servedRowids.empty()) {
+        string deleteSQL = string("DELETE FROM ") + names.indexTable + " WHERE rowid = ?;";
+        if (sqlite3_prepare_v2(database, deleteSQL.c_str(), -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_exec(database, "BEGIN TRANSACTION;", NULL, 0, NULL);
+            for (const auto& rowid : servedRowids) {
+                sqlite3_bind_int64(stmt, 1, rowid.second);
+                sqlite3_step(stmt);
+                sqlite3_reset(stmt);
+            }
+            sqlite3_exec(database, "COMMIT;", NULL, 0, NULL);
+            sqlite3_finalize(stmt);
+            cout << "Removed " << servedRowids.size() << " rows of missing files" << endl;
+        }
+    }
+
+    // Loads known vocabulary
+    set<string> knownWords;
+    if (!skipVocab) {
+        if (sqlite3_open(names.vocabFile, &vocabDatabase) != SQLITE_OK) {
+            cout << "Can't open vocabulary: " << sqlite3_errmsg(vocabDatabase) << endl;
+            sqlite3_close(database);
+            return 1;
+        }
+        sqlite3_busy_timeout(vocabDatabase, 5000);
+        sqlite3_exec(vocabDatabase, "PRAGMA journal_mode = WAL;", NULL, 0, NULL);
+
+        string createSQL = string("CREATE VIRTUAL TABLE IF NOT EXISTS ") + names.vocabTable +
+                           " USING fts5(vocabulary);";
+        sqlite3_exec(vocabDatabase, createSQL.c_str(), NULL, 0, NULL);
+
+        std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
+        readVocabulary(vocabDatabase, names.vocabTable, [&](const u32string& word) {
+            knownWords.insert(converter.to_bytes(word));
+        });
+    }
+
+    // Sets up inotify
+    int inotifyFd = inotify_init1(IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        cout << "Error initializing inotify" << endl;
+        sqlite3_close(database);
+        if (vocabDatabase)
+            sqlite3_close(vocabDatabase);
+        return 1;
+    }
+
+    map<int, filesystem::path> watches;
+    addWatches(inotifyFd, inputFolder, watches);
+    cout << "Watching " << watches.size() << " folders under " << inputFolder
+         << " (" << rowids.size() << " indexed files). Press any key + enter to stop." << endl;
+
+    set<filesystem::path> changedFiles;
+    auto firstChange = chrono::steady_clock::now();
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool running = true;
+
+    while (running) {
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+        int timeout = changedFiles.empty() ? -1 : debounceMs;
+        int ready = poll(fds, 2, timeout);
+
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        // Stops on keyboard entry
+        if (fds[1].revents & (POLLIN | POLLHUP))
+            running = false;
+
+        if (fds[0].revents & POLLIN) {
+            bool idle = changedFiles.empty();
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length;) {
+                inotify_event* event = (inotify_event*)(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                // Events were dropped: every folder is watched again and every
+                // file on disk or in the index is checked
+                if (event->mask & IN_Q_OVERFLOW) {
+                    cout << "inotify queue overflowed, rescanning " << inputFolder << endl;
+                    addWatches(inotifyFd, inputFolder, watches);
+                    for (const auto& entry :
+                         filesystem::recursive_directory_iterator(inputFolder, error))
+                        changedFiles.insert(entry.path());
+                    for (const auto& rowid : rowids)
+                        changedFiles.insert(rowid.first);
+                    continue;
+                }
+
+                // The folder was removed or its watch dropped by the kernel
+                if (event->mask & IN_IGNORED) {
+                    watches.erase(event->wd);
+                    continue;
+                }
+
+                auto watch = watches.find(event->wd);
+                if (watch == watches.end() || !event->len)
+                    continue;
+
+                filesystem::path path = watch->second / event->name;
+                if (event->mask & IN_ISDIR) {
+                    // New folders are watched and their files indexed
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        addWatches(inotifyFd, path, watches);
+                        for (const auto& entry :
+                             filesystem::recursive_directory_iterator(path, error))
+                            changedFiles.insert(entry.path());
+                    }
+
+                    // Files of folders moved away or deleted leave the index
+                    if (event->mask & (IN_MOVED_FROM | IN_DELETE)) {
+                        removeWatches(inotifyFd, path, watches);
+                        for (auto rowid = rowids.lower_bound(path);
+                             rowid != rowids.end() && isWithin(rowid->first, path);
+                             rowid++)
+                            changedFiles.insert(rowid->first);
+                    }
+                    continue;
+                }
+
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE))
+                    changedFiles.insert(path);
+            }
+
+            // A batch starts with its first file or folder
+            if (idle && !changedFiles.empty())
+                firstChange = chrono::steady_clock::now();
+        }
+
+        // Indexes once the folder is quiet, or the batch has waited too long
+        auto waited = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() -
+                                                                  firstChange)
+                          .count();
+        if (!changedFiles.empty() && (ready == 0 || !running || waited >= 10 * debounceMs)) {
+            cout << "Indexing " << changedFiles.size() << " changed files..." << endl;
+            indexBatch(database,
+                       vocabDatabase,
+                       names,
+                       imageMode,
+                       thumbnailFolder,
+                       changedFiles,
+                       rowids,
+                       knownWords);
+            changedFiles.clear();
+        }
+    }
+
+    close(inotifyFd);
+    sqlite3_close(database);
+    if (vocabDatabase)
+        sqlite3_close(vocabDatabase);
+    cout << "Stopped watching" << endl;
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Absolute folder path without a trailing separator, even if it does not exist yet
+ */
+static filesystem::path folderPath(const string& folder) {
+    filesystem::path path = filesystem::weakly_canonical(folder);
+    return path.has_filename() ? path : path.parent_path();
+}
+
 int main(int argc, const char* argv[]) {
     CommandLineParser parser(argc, argv);
 
@@ -585,17 +1276,55 @@ int main(int argc, const char* argv[]) {
 
     // Set up variables and constants;
     string inputFolder = parser.getOption("-path");
-    const char* databaseFile = htmlMode ? "index.db" : "images.db";
+    IndexNames names = getIndexNames(imageMode);
+    const char* databaseFile = names.indexFile;
     char* databaseErrorMessage;
     set<string> vocabSet;
+    BigramCounts bigramCounts;
+    PhraseMiner phraseMiner;
+
+    // Thumbnails default to a "thumbs" folder next to the indexed one, i.e. /thumbs/.
+    // The web root is the folder above -path, which is served as /special/
+    filesystem::path thumbnailFolder;
+    if (imageMode && parser.getOption("-thumbs") != "none") {
+        filesystem::path webRoot = folderPath(inputFolder).parent_path();
+        if (parser.hasOption("-thumbs"))
+            thumbnailFolder = folderPath(parser.getOption("-thumbs"));
+        else
+            thumbnailFolder = webRoot / "thumbs";
+
+        filesystem::path relative = thumbnailFolder.lexically_relative(webRoot);
+        if (relative.empty() || *relative.begin() == "..") {
+            cout << "warning: " << thumbnailFolder.string() << " is not under the web root "
+                 << webRoot.string() << ", thumbnails will not be served" << endl;
+            thumbnailUrl = "/" + thumbnailFolder.filename().string();
+        } else if (relative != ".")
+            thumbnailUrl = "/" + relative.generic_string();
+
+        if (!thumbnailsSupported()) {
+            cout << "warning: built without libpng/libjpeg, no thumbnails generated" << endl;
+            thumbnailFolder.clear();
+        } else {
+            error_code error;
+            filesystem::create_directories(thumbnailFolder, error);
+            cout << "Thumbnails folder: " << thumbnailFolder.string() << endl;
+        }
+    }
 
     //============================== INDEXING =============================//
 
     if (htmlMode) {
-        if (indexDatabase(inputFolder, databaseFile, vocabSet, appendIndex))
+        if (indexDatabase(
+                inputFolder, databaseFile, vocabSet, bigramCounts, phraseMiner, appendIndex))
             return 1;
     } else {
-        if (imageDatabase(inputFolder, databaseFile, vocabSet, appendIndex))
+        if (imageDatabase(inputFolder,
+                          databaseFile,
+                          vocabSet,
+                          bigramCounts,
+                          phraseMiner,
+                          appendIndex,
+                          thumbnailFolder))
             return 1;
     }
 
@@ -605,11 +1334,37 @@ int main(int argc, const char* argv[]) {
         //============================ VOCABULARY INDEXING =============================//
 
         // Create FTS5 virtual table for vocabulary
-        const char* vocabularyFile = htmlMode ? "index_vocab.db" : "images_vocab.db";
+        const char* vocabularyFile = names.vocabFile;
         char* databaseVocabErrorMessage;
-        const char* tableName_vocab = imageMode ? "images_vocab" : "webpage_vocab";
+        const char* tableName_vocab = names.vocabTable;
+
+        if (vocabularyDatabase(vocabularyFile, tableName_vocab, vocabSet, appendVocab))
+            return 1;
 
-        return vocabularyDatabase(vocabularyFile, tableName_vocab, vocabSet, appendVocab);
+        if (vocabularyAutomaton(names, vocabSet, appendVocab))
+            return 1;
+
+        if (bigramDatabase(names, bigramCounts, appendVocab))
+            return 1;
+
+        if (phraseDatabase(names, phraseMiner, appendVocab))
+            return 1;
+
+        if (spellingIndex(names))
+            return 1;
+    }
+
+    //============================== WATCH MODE =============================//
+
+    if (parser.hasOption("-watch")) {
+#ifdef __linux__
+        int debounceMs = parser.hasOption("-debounce") ? stoi(parser.getOption("-debounce")) : 500;
+        return watchDatabase(
+            inputFolder, imageMode, thumbnailFolder, skipVocab, max(debounceMs, 1));
+#else
+        cout << "error: -watch is only available on Linux" << endl;
+        return 1;
+#endif
     }
     return 0;
 }
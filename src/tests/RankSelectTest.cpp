@@ -0,0 +1,101 @@
+/**
+ * @file RankSelectTest.cpp
+ * @brief Checks RankSelectBitVector and LoudsTrie against naive counting
+ * @version 1.0
+ *
+ * Vector sizes and trie node counts cover every 64-bit word boundary up to
+ * a few blocks, where rank1 reads the directories past the last word.
+ */
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "LoudsTrie.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string& what) {
+    if (!condition) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+static void checkBitVector(size_t size, double density, mt19937& random) {
+    bernoulli_distribution bitDistribution(density);
+    vector<bool> bits;
+    RankSelectBitVector vector;
+    for (size_t i = 0; i < size; i++) {
+        bool bit = bitDistribution(random);
+        bits.push_back(bit);
+        vector.pushBack(bit);
+    }
+    vector.finish();
+
+    string name = "size " + to_string(size) + ", density " + to_string(density);
+    size_t ones = 0, zeros = 0;
+    for (size_t position = 0; position <= size; position++) {
+        if (vector.rank1(position) != ones) {
+            check(false, name + ": rank1(" + to_string(position) + ")");
+            return;
+        }
+        if (position == size)
+            break;
+
+        if (bits[position])
+            ones++;
+        else if (vector.select0(zeros++) != position) {
+            check(false, name + ": select0(" + to_string(zeros - 1) + ")");
+            return;
+        }
+    }
+}
+
+static void checkTrie(size_t wordCount, mt19937& random) {
+    uniform_int_distribution<int> letter('a', 'c');
+    uniform_int_distribution<size_t> length(1, 6);
+    set<string> unique;
+    while (unique.size() < wordCount) {
+        string word(length(random), ' ');
+        for (char& c : word)
+            c = (char)letter(random);
+        unique.insert(word);
+    }
+    vector<string> words(unique.begin(), unique.end());
+
+    LoudsTrie trie;
+    trie.build(words);
+    string name = to_string(trie.getNodeCount()) + " nodes";
+    check(trie.getWordCount() == words.size(), name + ": getWordCount()");
+    for (const string& word : words) {
+        if (!trie.contains(word) || !trie.startsWith(word.substr(0, 1))) {
+            check(false, name + ": contains(\"" + word + "\")");
+            return;
+        }
+    }
+}
+
+int main() {
+    mt19937 random(64);
+
+    for (size_t size = 0; size <= 4 * 512 + 64; size++) {
+        for (double density : {0.1, 0.5, 0.9})
+            checkBitVector(size, density, random);
+    }
+
+    // Node counts land on every residue modulo 64 several times over
+    for (size_t wordCount = 1; wordCount <= 400; wordCount++)
+        checkTrie(wordCount, random);
+
+    if (failures) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All checks passed" << endl;
+    return 0;
+}
@@ -6,36 +6,325 @@
 
 #include "trie.h"
 
+#include "Trace.h"
+
 #include <unicode/uchar.h>
 #include <unicode/ustring.h>
 
-TrieNode* TrieNode::retrieveChild(char32_t c) {
-    // Searches for child node
-    auto it = children.find(c);
-    if (it != children.end()) {
-        return it->second;
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef __linux__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <cstring>
+#include <thread>
+
+static const uint16_t NO_SYMBOL = 0xFFFF;
+
+//=============================== NODES ================================//
+
+TrieNode* TrieNode::create() {
+    return new TrieNode4();
+}
+
+void TrieNode::destroy(TrieNode* node) {
+    if (!node)
+        return;
+
+    node->forEachChild([](uint8_t, TrieNode* child) { destroy(child); });
+
+    switch (node->type) {
+        case NODE4:
+            delete static_cast<TrieNode4*>(node);
+            break;
+        case NODE16:
+            delete static_cast<TrieNode16*>(node);
+            break;
+        case NODE48:
+            delete static_cast<TrieNode48*>(node);
+            break;
+        case NODE256:
+            delete static_cast<TrieNode256*>(node);
+            break;
+    }
+}
+
+TrieNode** TrieNode::childSlot(uint8_t symbol) {
+    switch (type) {
+        case NODE4: {
+            auto node = static_cast<TrieNode4*>(this);
+            for (int i = 0; i < count; i++) {
+                if (node->keys[i] == symbol)
+                    return &node->children[i];
+            }
+            return nullptr;
+        }
+        case NODE16: {
+            auto node = static_cast<TrieNode16*>(this);
+#if defined(__SSE2__) || defined(_M_X64)
+            // Compares all 16 keys at once
+            __m128i keys = _mm_loadu_si128((const __m128i*)node->keys);
+            __m128i matches = _mm_cmpeq_epi8(keys, _mm_set1_epi8((char)symbol));
+            unsigned mask = (unsigned)_mm_movemask_epi8(matches) & ((1U << count) - 1);
+            if (!mask)
+                return nullptr;
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return &node->children[index];
+#else
+            return &node->children[__builtin_ctz(mask)];
+#endif
+#else
+            for (int i = 0; i < count; i++) {
+                if (node->keys[i] == symbol)
+                    return &node->children[i];
+            }
+            return nullptr;
+#endif
+        }
+        case NODE48: {
+            auto node = static_cast<TrieNode48*>(this);
+            uint8_t slot = node->slots[symbol];
+            return slot == TrieNode48::EMPTY_SLOT ? nullptr : &node->children[slot];
+        }
+        case NODE256: {
+            auto node = static_cast<TrieNode256*>(this);
+            return node->children[symbol] ? &node->children[symbol] : nullptr;
+        }
     }
     return nullptr;
 }
 
-bool TrieNode::insertCharacter(char32_t c) {
-    // Inserts character if not already present
-    if (children.find(c) == children.end()) {
-        children[c] = new TrieNode();
-        return true;
+TrieNode* TrieNode::retrieveChild(uint8_t symbol) const {
+    TrieNode** slot = const_cast<TrieNode*>(this)->childSlot(symbol);
+    return slot ? *slot : nullptr;
+}
+
+TrieNode* TrieNode::nextChild(unsigned& position, uint8_t& symbol) const {
+    switch (type) {
+        case NODE4:
+        case NODE16: {
+            // Sorted key arrays: position indexes keys directly
+            const uint8_t* keys = type == NODE4 ? static_cast<const TrieNode4*>(this)->keys
+                                                : static_cast<const TrieNode16*>(this)->keys;
+            TrieNode* const* children = type == NODE4
+                                            ? static_cast<const TrieNode4*>(this)->children
+                                            : static_cast<const TrieNode16*>(this)->children;
+            if (position >= count)
+                return nullptr;
+            symbol = keys[position];
+            return children[position++];
+        }
+        case NODE48: {
+            auto node = static_cast<const TrieNode48*>(this);
+            for (; position < 256; position++) {
+                if (node->slots[position] != TrieNode48::EMPTY_SLOT) {
+                    symbol = (uint8_t)position;
+                    return node->children[node->slots[position++]];
+                }
+            }
+            return nullptr;
+        }
+        case NODE256: {
+            auto node = static_cast<const TrieNode256*>(this);
+            for (; position < 256; position++) {
+                if (node->children[position]) {
+                    symbol = (uint8_t)position;
+                    return node->children[position++];
+                }
+            }
+            return nullptr;
+        }
     }
-    return false;
+    return nullptr;
 }
 
-bool Trie::insert(const std::u32string& word) {
-    TrieNode* currentNode = root;
+/**
+ * @brief Inserts into a sorted key array, shifting larger keys right
+ */
+template <typename Node>
+static TrieNode*& insertSorted(Node* node, uint8_t symbol) {
+    int position = 0;
+    while (position < node->count && node->keys[position] < symbol)
+        position++;
+
+    memmove(node->keys + position + 1, node->keys + position, node->count - position);
+    memmove(node->children + position + 1,
+            node->children + position,
+            (node->count - position) * sizeof(TrieNode*));
+
+    node->keys[position] = symbol;
+    node->children[position] = TrieNode::create();
+    node->count++;
+    return node->children[position];
+}
+
+/**
+ * @brief Copies the header and children of a full node into the next type
+ */
+template <typename Node>
+static Node* growNode(TrieNode* node) {
+    Node* grown = new Node();
+    grown->isEndOfWord = node->isEndOfWord;
+    node->forEachChild([&](uint8_t symbol, TrieNode* child) {
+        if constexpr (std::is_same<Node, TrieNode16>::value) {
+            grown->keys[grown->count] = symbol;
+            grown->children[grown->count] = child;
+        } else if constexpr (std::is_same<Node, TrieNode48>::value) {
+            grown->slots[symbol] = (uint8_t)grown->count;
+            grown->children[grown->count] = child;
+        } else {
+            grown->children[symbol] = child;
+        }
+        grown->count++;
+    });
+    return grown;
+}
+
+TrieNode*& TrieNode::insertCharacter(TrieNode*& node, uint8_t symbol) {
+    // Inserts symbol if not already present
+    TrieNode** slot = node->childSlot(symbol);
+    if (slot)
+        return *slot;
+
+    switch (node->type) {
+        case NODE4:
+            if (node->count < 4)
+                return insertSorted(static_cast<TrieNode4*>(node), symbol);
+            {
+                TrieNode* grown = growNode<TrieNode16>(node);
+                delete static_cast<TrieNode4*>(node);
+                node = grown;
+            }
+            return insertSorted(static_cast<TrieNode16*>(node), symbol);
+        case NODE16:
+            if (node->count < 16)
+                return insertSorted(static_cast<TrieNode16*>(node), symbol);
+            {
+                TrieNode* grown = growNode<TrieNode48>(node);
+                delete static_cast<TrieNode16*>(node);
+                node = grown;
+            }
+            return insertCharacter(node, symbol);
+        case NODE48: {
+            if (node->count == 48) {
+                TrieNode* grown = growNode<TrieNode256>(node);
+                delete static_cast<TrieNode48*>(node);
+                node = grown;
+                return insertCharacter(node, symbol);
+            }
+            auto node48 = static_cast<TrieNode48*>(node);
+            node48->slots[symbol] = (uint8_t)node48->count;
+            node48->children[node48->count] = TrieNode::create();
+            return node48->children[node48->count++];
+        }
+        case NODE256: {
+            auto node256 = static_cast<TrieNode256*>(node);
+            node256->children[symbol] = TrieNode::create();
+            node256->count++;
+            return node256->children[symbol];
+        }
+    }
+    return node;
+}
+
+//============================== ALPHABET ==============================//
+
+Trie::Trie() : root(TrieNode::create()) {
+    directSymbols.fill(NO_SYMBOL);
+}
+
+Trie::~Trie() {
+    TrieNode::destroy(root);
+}
+
+int Trie::lookupSymbol(char32_t c) const {
+    if (c < DIRECT_SYMBOLS)
+        return directSymbols[c] == NO_SYMBOL ? -1 : directSymbols[c];
+
+    auto symbol = otherSymbols.find(c);
+    return symbol == otherSymbols.end() ? -1 : symbol->second;
+}
+
+bool Trie::assignSymbol(char32_t c) {
+    if (lookupSymbol(c) >= 0)
+        return true;
+    if (symbolCharacters.size() >= ESCAPE_SYMBOL)
+        return false;
 
-    // Inserts each character of the word
+    uint8_t symbol = (uint8_t)symbolCharacters.size();
+    symbolCharacters.push_back(c);
+    if (c < DIRECT_SYMBOLS)
+        directSymbols[c] = symbol;
+    else
+        otherSymbols[c] = symbol;
+    return true;
+}
+
+bool Trie::encode(const std::u32string& word, std::string& symbols) const {
+    symbols.clear();
     for (char32_t c : word) {
-        currentNode->insertCharacter(c);
-        currentNode = currentNode->retrieveChild(c);
+        int symbol = lookupSymbol(c);
+        if (symbol >= 0) {
+            symbols.push_back((char)symbol);
+        } else if (symbolCharacters.size() >= ESCAPE_SYMBOL) {
+            // Alphabet is full: spells the code point out
+            symbols.push_back((char)ESCAPE_SYMBOL);
+            symbols.push_back((char)((c >> 14) & 0x7F));
+            symbols.push_back((char)((c >> 7) & 0x7F));
+            symbols.push_back((char)(c & 0x7F));
+        } else {
+            // Never inserted, so no word contains it
+            return false;
+        }
+    }
+    return true;
+}
+
+void Trie::decode(const std::string& symbols, std::u32string& word) const {
+    word.clear();
+    word.reserve(symbols.size());
+    for (size_t i = 0; i < symbols.size(); i++) {
+        uint8_t symbol = (uint8_t)symbols[i];
+        if (symbol == ESCAPE_SYMBOL && i + 3 < symbols.size()) {
+            word.push_back(((char32_t)symbols[i + 1] << 14) | ((char32_t)symbols[i + 2] << 7) |
+                           (char32_t)symbols[i + 3]);
+            i += 3;
+        } else {
+            word.push_back(symbolCharacters[symbol]);
+        }
     }
-    return currentNode->isEndOfWord = true;
+}
+
+//================================ TRIE ================================//
+
+void Trie::insertBelow(TrieNode*& node, const std::string& symbols, size_t start) {
+    // Walks parent slots, since any node on the path may be replaced when it grows
+    TrieNode** slot = &node;
+    for (size_t i = start; i < symbols.size(); i++)
+        slot = &TrieNode::insertCharacter(*slot, (uint8_t)symbols[i]);
+    (*slot)->isEndOfWord = true;
+}
+
+bool Trie::insert(const std::u32string& word) {
+    for (char32_t c : word)
+        assignSymbol(c);
+
+    std::string symbols;
+    encode(word, symbols);
+    insertBelow(root, symbols, 0);
+    return true;
 }
 
 bool Trie::insert(const std::string& word) {
@@ -44,17 +333,102 @@ bool Trie::insert(const std::string& word) {
     return insert(utf32Word);
 }
 
-bool Trie::search(const std::u32string& word) {
-    TrieNode* currentNode = root;
+size_t Trie::insertParallel(const std::vector<std::u32string>& words, unsigned threadCount) {
+    TRACE_SPAN("Trie::insertParallel");
 
-    // Traverses the Trie for each character
-    for (char32_t c : word) {
-        currentNode = currentNode->retrieveChild(c);
-        if (!currentNode) {
-            return false;
+    // Assigns symbols most frequent first, so rare scripts are the ones escaped
+    std::unordered_map<char32_t, size_t> frequencies;
+    for (const auto& word : words) {
+        for (char32_t c : word)
+            frequencies[c]++;
+    }
+    std::vector<std::pair<size_t, char32_t>> byFrequency;
+    for (auto& frequency : frequencies)
+        byFrequency.emplace_back(frequency.second, frequency.first);
+    std::sort(byFrequency.begin(), byFrequency.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    // Within the alphabet, ids follow code point order, so enumeration stays sorted
+    std::vector<char32_t> alphabet;
+    for (auto& entry : byFrequency) {
+        if (alphabet.size() + symbolCharacters.size() >= ESCAPE_SYMBOL)
+            break;
+        if (lookupSymbol(entry.second) < 0)
+            alphabet.push_back(entry.second);
+    }
+    std::sort(alphabet.begin(), alphabet.end());
+    for (char32_t c : alphabet)
+        assignSymbol(c);
+
+    // Encodes and partitions words by first symbol
+    std::vector<std::string> encoded(words.size());
+    std::vector<std::vector<const std::string*>> partitions(256);
+    for (size_t i = 0; i < words.size(); i++) {
+        encode(words[i], encoded[i]);
+        if (encoded[i].empty())
+            root->isEndOfWord = true;
+        else
+            partitions[(uint8_t)encoded[i][0]].push_back(&encoded[i]);
+    }
+
+    // Root children are created up front; workers then only touch their own subtrie
+    std::vector<uint8_t> firstSymbols;
+    for (int symbol = 0; symbol < 256; symbol++) {
+        if (!partitions[symbol].empty()) {
+            TrieNode::insertCharacter(root, (uint8_t)symbol);
+            firstSymbols.push_back((uint8_t)symbol);
         }
     }
-    return currentNode->isEndOfWord;
+
+    // Largest partitions first, so the slowest one starts early
+    std::sort(firstSymbols.begin(), firstSymbols.end(), [&](uint8_t a, uint8_t b) {
+        return partitions[a].size() > partitions[b].size();
+    });
+
+    if (!threadCount)
+        threadCount = std::max(1U, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, std::max<size_t>(1, firstSymbols.size()));
+
+    std::atomic<size_t> nextTask(0);
+    auto worker = [&]() {
+        for (size_t task = nextTask++; task < firstSymbols.size(); task = nextTask++) {
+            // The root no longer grows, so its child slots stay put
+            TrieNode** subtrie = root->childSlot(firstSymbols[task]);
+            for (const std::string* word : partitions[firstSymbols[task]])
+                insertBelow(*subtrie, *word, 1);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threadCount; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers)
+        thread.join();
+
+    return words.size();
+}
+
+TrieNode* Trie::walk(const std::string& symbols) const {
+    TrieNode* currentNode = root;
+
+    // Traverses the Trie for each symbol
+    for (char symbol : symbols) {
+        currentNode = currentNode->retrieveChild((uint8_t)symbol);
+        if (!currentNode)
+            return nullptr;
+    }
+    return currentNode;
+}
+
+bool Trie::search(const std::u32string& word) {
+    std::string symbols;
+    if (!encode(word, symbols))
+        return false;
+
+    TrieNode* node = walk(symbols);
+    return node && node->isEndOfWord;
 }
 
 bool Trie::search(const std::string& word) {
@@ -64,16 +438,8 @@ bool Trie::search(const std::string& word) {
 }
 
 bool Trie::startsWith(const std::u32string& prefix) {
-    TrieNode* currentNode = root;
-
-    // Traverses the Trie for each character
-    for (char32_t c : prefix) {
-        currentNode = currentNode->retrieveChild(c);
-        if (!currentNode) {
-            return false;
-        }
-    }
-    return true;
+    std::string symbols;
+    return encode(prefix, symbols) && walk(symbols);
 }
 
 bool Trie::startsWith(const std::string& prefix) {
@@ -84,55 +450,212 @@ bool Trie::startsWith(const std::string& prefix) {
 
 size_t Trie::collectSuggestions(const std::u32string& prefix, size_t maxSuggestions) {
     collectWords.clear();
+    return collectSuggestions(prefix, maxSuggestions, collectWords, SUGGEST_SYMBOL_ORDER);
+}
+
+size_t Trie::collectSuggestions(const std::string& prefix, size_t maxSuggestions) {
+    // Converts to UTF-32 and collects suggestions
+    std::u32string utf32Prefix = converter.from_bytes(prefix);
+    return collectSuggestions(utf32Prefix, maxSuggestions);
+}
+
+void Trie::appendSuggestion(const std::string& symbols,
+                            std::vector<std::u32string>& suggestions) const {
+    suggestions.emplace_back();
+    decode(symbols, suggestions.back());
+    for (char32_t& c : suggestions.back())
+        c = u_tolower(c);
+}
+
+// Depth-first frame: a node, its next child and the symbols above it
+struct DepthFrame {
+    const TrieNode* node;
+    unsigned position;
+    uint32_t depth;
+};
+
+// Breadth-first entry: the path is rebuilt from the parent links
+struct QueueEntry {
+    const TrieNode* node;
+    uint32_t parent;
+    uint8_t symbol;
+};
+
+// Enumeration buffers, grown once per thread and reused by every call
+struct CollectScratch {
+    std::string symbols;
+    std::string path;
+    std::vector<DepthFrame> stack;
+    std::vector<QueueEntry> queue;
+};
+
+static thread_local CollectScratch collectScratch;
+
+size_t Trie::collectSuggestions(const std::u32string& prefix,
+                                size_t maxSuggestions,
+                                std::vector<std::u32string>& suggestions,
+                                SuggestionOrder order) const {
+    TRACE_SPAN("Trie::collectSuggestions");
+    CollectScratch& scratch = collectScratch;
 
     // Checks if prefix exists
-    if (!startsWith(prefix) || maxSuggestions == 0) {
+    std::string& symbols = scratch.symbols;
+    if (maxSuggestions == 0 || !encode(prefix, symbols))
         return 0;
+
+    const TrieNode* start = walk(symbols);
+    if (!start)
+        return 0;
+
+    size_t added = 0;
+    if (start->isEndOfWord) {
+        appendSuggestion(symbols, suggestions);
+        added++;
     }
+    const uint32_t prefixLength = (uint32_t)symbols.size();
 
-    TrieNode* currentNode = root;
-    std::u32string currentPrefix;
+    if (order == SUGGEST_SYMBOL_ORDER) {
+        // Depth-first: the stack never grows past the longest word
+        auto& stack = scratch.stack;
+        stack.clear();
+        stack.push_back({start, 0, prefixLength});
+        while (!stack.empty() && added < maxSuggestions) {
+            DepthFrame& frame = stack.back();
+            uint8_t symbol;
+            const TrieNode* child = frame.node->nextChild(frame.position, symbol);
+            if (!child) {
+                stack.pop_back();
+                continue;
+            }
 
-    // Traverses to the end of the prefix
-    for (char32_t c : prefix) {
-        currentPrefix.push_back(u_tolower(c));
-        currentNode = currentNode->retrieveChild(c);
+            symbols.resize(frame.depth);
+            symbols.push_back((char)symbol);
+            if (child->isEndOfWord) {
+                appendSuggestion(symbols, suggestions);
+                added++;
+            }
+            stack.push_back({child, 0, (uint32_t)symbols.size()});
+        }
+        return added;
     }
 
-    // Performs DFS to collect suggestions
-    DFSCollector(currentNode, currentPrefix, maxSuggestions);
+    // Breadth-first: nodes are visited level by level, so the first
+    // maxSuggestions words found are the shortest ones
+    auto& queue = scratch.queue;
+    std::string& path = scratch.path;
+    queue.clear();
+    queue.push_back({start, 0, 0});
+    for (uint32_t head = 0; head < queue.size() && added < maxSuggestions; head++) {
+        unsigned position = 0;
+        uint8_t symbol;
+        while (added < maxSuggestions) {
+            const TrieNode* child = queue[head].node->nextChild(position, symbol);
+            if (!child)
+                break;
 
-    return collectWords.size();
+            queue.push_back({child, head, symbol});
+            if (!child->isEndOfWord)
+                continue;
+
+            // Rebuilds the word from the parent links, leaf to start
+            path.clear();
+            for (uint32_t entry = (uint32_t)queue.size() - 1; entry != 0;
+                 entry = queue[entry].parent)
+                path.push_back((char)queue[entry].symbol);
+            symbols.resize(prefixLength);
+            symbols.append(path.rbegin(), path.rend());
+            appendSuggestion(symbols, suggestions);
+            added++;
+        }
+    }
+    return added;
 }
 
-size_t Trie::collectSuggestions(const std::string& prefix, size_t maxSuggestions) {
-    // Converts to UTF-32 and collects suggestions
-    std::u32string utf32Prefix = converter.from_bytes(prefix);
-    return collectSuggestions(utf32Prefix, maxSuggestions);
+//================================ STATS ================================//
+
+const char* TrieStats::fanoutLabel(size_t bucket) {
+    static const char* const labels[FANOUT_BUCKETS] = {
+        "0", "1", "2", "3-4", "5-16", "17-48", "49-256"};
+    return bucket < FANOUT_BUCKETS ? labels[bucket] : "";
 }
 
-void Trie::DFSCollector(TrieNode* node, std::u32string& currentWord, size_t& maxSuggestions) {
-    // Returns if reached max suggestions
-    if (!maxSuggestions) {
-        return;
-    }
+size_t TrieStats::fanoutBucket(size_t children) {
+    if (children <= 2)
+        return children;
+    if (children <= 4)
+        return 3;
+    if (children <= 16)
+        return 4;
+    return children <= 48 ? 5 : 6;
+}
 
-    // If end of word, add to suggestions
-    if (node->isEndOfWord) {
-        collectWords.push_back(currentWord);
-        maxSuggestions--;
-    }
+/**
+ * @brief Bytes the allocator really spends on a block
+ */
+static size_t allocatedSize(const void* block, size_t requested) {
+#ifdef __linux__
+    // Usable size plus the chunk header
+    (void)requested;
+    return malloc_usable_size(const_cast<void*>(block)) + sizeof(size_t);
+#else
+    // Typical 16-byte granularity with an 8-byte header
+    (void)block;
+    return (requested + sizeof(size_t) + 15) & ~(size_t)15;
+#endif
+}
+
+TrieStats Trie::getStats() const {
+    TRACE_SPAN("Trie::getStats");
+    TrieStats stats;
+    size_t depthSum = 0;
+
+    std::vector<std::pair<const TrieNode*, size_t>> stack;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+        const TrieNode* node = stack.back().first;
+        size_t depth = stack.back().second;
+        stack.pop_back();
 
-    // Traverse children
-    for (auto& childIterator : node->children) {
-        // Add character to current word and recurse
-        currentWord.push_back(u_tolower(childIterator.first));
-        DFSCollector(childIterator.second, currentWord, maxSuggestions);
-        // Goes back one character
-        currentWord.pop_back();
-        // Avoids unnecessary traversals
-        if (!maxSuggestions) {
-            return;
+        size_t size = 0;
+        switch (node->type) {
+            case TrieNode::NODE4:
+                size = sizeof(TrieNode4);
+                break;
+            case TrieNode::NODE16:
+                size = sizeof(TrieNode16);
+                break;
+            case TrieNode::NODE48:
+                size = sizeof(TrieNode48);
+                break;
+            case TrieNode::NODE256:
+                size = sizeof(TrieNode256);
+                break;
         }
+        stats.nodeCount++;
+        stats.nodeTypes[node->type]++;
+        stats.nodeBytes += size;
+        stats.allocatedBytes += allocatedSize(node, size);
+
+        if (node->isEndOfWord) {
+            stats.wordCount++;
+            depthSum += depth;
+            stats.maxDepth = std::max(stats.maxDepth, depth);
+        }
+
+        size_t children = 0;
+        node->forEachChild([&](uint8_t, TrieNode* child) {
+            stack.emplace_back(child, depth + 1);
+            children++;
+        });
+        if (stats.fanout.size() <= depth)
+            stats.fanout.resize(depth + 1);
+        stats.fanout[depth][TrieStats::fanoutBucket(children)]++;
     }
+
+    stats.averageDepth = stats.wordCount ? (double)depthSum / stats.wordCount : 0;
+    stats.alphabetSize = symbolCharacters.size();
+    // Hash map entries are counted as key, value and two pointers
+    stats.alphabetBytes = sizeof(directSymbols) + symbolCharacters.capacity() * sizeof(char32_t) +
+                          otherSymbols.size() * (sizeof(char32_t) + 1 + 2 * sizeof(void*));
+    return stats;
 }
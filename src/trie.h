@@ -7,55 +7,202 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <algorithm>
+#include <array>
 #include <codecvt>
+#include <cstdint>
+#include <iterator>
 #include <locale>
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /**
  * @class TrieNode
  * @brief Node structure for Trie implementation
+ *
+ * Adaptive node (as in ART): children are keyed by one-byte symbol ids and
+ * the node grows from Node4 to Node16, Node48 and Node256 as children are
+ * added. Node4/16 keep sorted key arrays (Node16 is searched with a single
+ * SIMD compare), Node48 maps symbols to 48 slots and Node256 is indexed
+ * directly.
  */
 class TrieNode {
   public:
-    TrieNode() : isEndOfWord(false) {
-    }
-    ~TrieNode() {
-        for (auto child : children) {
-            if (child.second) {
-                delete child.second;
-            }
-        }
-    }
+    enum Type : uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+    /**
+     * @name create
+     * @brief Allocates an empty Node4
+     */
+    static TrieNode* create();
+
+    /**
+     * @name destroy
+     * @brief Frees a node and its whole subtree
+     */
+    static void destroy(TrieNode* node);
 
     /**
      * @name retrieveChild
-     * @brief Retrieves child node for given character
-     * @param c Character to retrieve
+     * @brief Retrieves child node for given symbol
+     * @param symbol Symbol id to retrieve
      * @return Pointer to child TrieNode or nullptr if not found
      */
-    TrieNode* retrieveChild(char32_t c);
+    TrieNode* retrieveChild(uint8_t symbol) const;
+
+    /**
+     * @name childSlot
+     * @brief Address of the pointer to the child for a symbol
+     * @return Slot inside this node or nullptr if not found
+     */
+    TrieNode** childSlot(uint8_t symbol);
 
     /**
      * @name insertCharacter
-     * @brief Inserts a character as a child node
-     * @param c Character to insert
-     * @return True if character was inserted, false if it already existed
+     * @brief Returns the child slot for a symbol, adding the child if missing
+     *
+     * A full node is replaced by the next larger type, so node is updated.
+     * The returned slot lives in the (possibly new) node, so growing the
+     * child later updates its parent too.
+     *
+     * @param node Reference to the parent pointer
+     * @param symbol Symbol id to insert
+     * @return Reference to the child pointer
+     */
+    static TrieNode*& insertCharacter(TrieNode*& node, uint8_t symbol);
+
+    /**
+     * @name nextChild
+     * @brief Resumable child iteration in ascending symbol order
+     *
+     * Start with position 0; each call returns the next child and its
+     * symbol, or nullptr once the children are exhausted.
+     *
+     * @param position Iteration state, advanced past the returned child
+     * @param symbol Symbol of the returned child
+     */
+    TrieNode* nextChild(unsigned& position, uint8_t& symbol) const;
+
+    /**
+     * @name forEachChild
+     * @brief Calls visit(symbol, child) in ascending symbol order
      */
-    bool insertCharacter(char32_t c);
+    template <typename Visit>
+    void forEachChild(Visit visit) const;
 
-    std::map<char32_t, TrieNode*> children;
+    Type type;
     bool isEndOfWord;
+    uint16_t count;
+
+  protected:
+    explicit TrieNode(Type type) : type(type), isEndOfWord(false), count(0) {
+    }
 };
 
-class Trie {
-  public:
-    Trie() : root(new TrieNode()) {
+struct TrieNode4 : TrieNode {
+    TrieNode4() : TrieNode(NODE4) {
     }
-    ~Trie() {
-        delete root;
+    uint8_t keys[4];
+    TrieNode* children[4];
+};
+
+struct TrieNode16 : TrieNode {
+    TrieNode16() : TrieNode(NODE16) {
     }
+    uint8_t keys[16];
+    TrieNode* children[16];
+};
+
+struct TrieNode48 : TrieNode {
+    TrieNode48() : TrieNode(NODE48) {
+        std::fill(std::begin(slots), std::end(slots), EMPTY_SLOT);
+    }
+    static constexpr uint8_t EMPTY_SLOT = 0xFF;
+    uint8_t slots[256];
+    TrieNode* children[48];
+};
+
+struct TrieNode256 : TrieNode {
+    TrieNode256() : TrieNode(NODE256), children() {
+    }
+    TrieNode* children[256];
+};
+
+template <typename Visit>
+void TrieNode::forEachChild(Visit visit) const {
+    switch (type) {
+        case NODE4: {
+            auto node = static_cast<const TrieNode4*>(this);
+            for (int i = 0; i < count; i++)
+                visit(node->keys[i], node->children[i]);
+            break;
+        }
+        case NODE16: {
+            auto node = static_cast<const TrieNode16*>(this);
+            for (int i = 0; i < count; i++)
+                visit(node->keys[i], node->children[i]);
+            break;
+        }
+        case NODE48: {
+            auto node = static_cast<const TrieNode48*>(this);
+            for (int symbol = 0; symbol < 256; symbol++) {
+                if (node->slots[symbol] != TrieNode48::EMPTY_SLOT)
+                    visit((uint8_t)symbol, node->children[node->slots[symbol]]);
+            }
+            break;
+        }
+        case NODE256: {
+            auto node = static_cast<const TrieNode256*>(this);
+            for (int symbol = 0; symbol < 256; symbol++) {
+                if (node->children[symbol])
+                    visit((uint8_t)symbol, node->children[symbol]);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Shape and memory of a Trie, for /admin/stats
+ *
+ * Depths count symbols, so code points outside the alphabet count as four.
+ */
+struct TrieStats {
+    // Fan-out buckets: 0, 1, 2, 3-4, 5-16, 17-48, 49-256 children
+    static const size_t FANOUT_BUCKETS = 7;
+    static const char* fanoutLabel(size_t bucket);
+    static size_t fanoutBucket(size_t children);
+
+    size_t nodeCount = 0;
+    size_t wordCount = 0;
+    // Nodes of each TrieNode::Type
+    size_t nodeTypes[4] = {};
+    // Sum of node object sizes
+    size_t nodeBytes = 0;
+    // Node bytes as allocated, with allocator headers and rounding
+    size_t allocatedBytes = 0;
+    size_t alphabetSize = 0;
+    size_t alphabetBytes = 0;
+    size_t maxDepth = 0;
+    // Average depth of the words
+    double averageDepth = 0;
+    // fanout[depth][bucket]: nodes at that depth whose child count is in bucket
+    std::vector<std::array<size_t, FANOUT_BUCKETS>> fanout;
+};
+
+/**
+ * @brief Order in which Trie::collectSuggestions enumerates words
+ */
+enum SuggestionOrder {
+    SUGGEST_SYMBOL_ORDER,    // Depth-first, in symbol order
+    SUGGEST_SHORTEST_FIRST,  // Breadth-first: shorter words first, symbol order within a length
+};
+
+class Trie {
+  public:
+    Trie();
+    ~Trie();
 
     /**
      * @name insert
@@ -66,6 +213,20 @@ class Trie {
     bool insert(const std::u32string& word);
     bool insert(const std::string& word);
 
+    /**
+     * @name insertParallel
+     * @brief Inserts many words, building each first-letter subtrie on its own thread
+     *
+     * Words are partitioned by first symbol; every partition is inserted
+     * below its own root child, so threads never share a node. The symbol
+     * alphabet is assigned beforehand, most frequent code points first.
+     *
+     * @param words The words to insert
+     * @param threadCount Worker threads (0 uses one per core)
+     * @return Number of words inserted
+     */
+    size_t insertParallel(const std::vector<std::u32string>& words, unsigned threadCount = 0);
+
     /**
      * @name search
      * @brief Searches for a word in the Trie
@@ -87,6 +248,10 @@ class Trie {
     /**
      * @name collectSuggestions
      * @brief Collects words in the Trie that start with the given prefix
+     *
+     * Words come out in symbol order: code point order after insertParallel
+     * (escaped code points last), first-seen order after plain inserts.
+     *
      * @param prefix The prefix to search for
      * @param maxSuggestions Maximum number of suggestions to collect
      * @return Number of suggestions collected
@@ -94,13 +259,59 @@ class Trie {
     size_t collectSuggestions(const std::u32string& prefix, size_t maxSuggestions);
     size_t collectSuggestions(const std::string& prefix, size_t maxSuggestions);
 
+    /**
+     * @name collectSuggestions
+     * @brief Appends up to maxSuggestions words starting with prefix
+     *
+     * Iterative: depth-first keeps one frame per symbol of depth, breadth-
+     * first a queue of the nodes visited before the cutoff. Both reuse
+     * per-thread buffers, so only the returned words allocate, and several
+     * threads may collect at once while nothing is inserted. Shortest-first
+     * compares encoded lengths: code points outside the alphabet count as
+     * four symbols.
+     *
+     * @param prefix The prefix to search for
+     * @param maxSuggestions Maximum number of suggestions to collect
+     * @param suggestions Output words (lowercase)
+     * @param order Enumeration order
+     * @return Number of suggestions appended
+     */
+    size_t collectSuggestions(const std::u32string& prefix,
+                              size_t maxSuggestions,
+                              std::vector<std::u32string>& suggestions,
+                              SuggestionOrder order) const;
+
+    /**
+     * @name getStats
+     * @brief Walks every node and reports shape and memory usage
+     */
+    TrieStats getStats() const;
+
     // Public member to store collected words
     std::vector<std::u32string> collectWords;
 
   private:
+    // Code points beyond the 255-symbol alphabet are spelled as ESCAPE_SYMBOL
+    // followed by three 7-bit symbols
+    static const uint8_t ESCAPE_SYMBOL = 0xFF;
+    static const size_t DIRECT_SYMBOLS = 0x800;
+
+    int lookupSymbol(char32_t c) const;
+    bool assignSymbol(char32_t c);
+    bool encode(const std::u32string& word, std::string& symbols) const;
+    void decode(const std::string& symbols, std::u32string& word) const;
+    TrieNode* walk(const std::string& symbols) const;
+
+    static void insertBelow(TrieNode*& node, const std::string& symbols, size_t start);
+    void appendSuggestion(const std::string& symbols,
+                          std::vector<std::u32string>& suggestions) const;
+
     TrieNode* root;
     std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
 
-    void DFSCollector(TrieNode* node, std::u32string& currentWord, size_t& maxSuggestions);
+    // Alphabet: code point -> symbol id (direct table for the common range)
+    std::array<uint16_t, DIRECT_SYMBOLS> directSymbols;
+    std::unordered_map<char32_t, uint8_t> otherSymbols;
+    std::vector<char32_t> symbolCharacters;
 };
 #endif